@@ -0,0 +1,294 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It implements
+ *          a benchmark for the "do it yourself" approach (see diy.c).
+ *          It is not part of xautolock itself.
+ *
+ *          It builds a tree of width^depth windows, hands the server
+ *          over to the DIY code, and meanwhile has a separate process
+ *          create and destroy windows at a given rate. Once the storm
+ *          is over and all windows have been dealt with, it reports
+ *          what the whole exercise has cost. Run it by means of
+ *          diybench.sh, which provides a private Xvfb server.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <poll.h>
+
+#include "diy.h"
+#include "miscutil.h"
+
+/*
+ *  The bits of xautolock that diy.c relies upon. We never lock.
+ */
+time_t lockTime = 0, killTime = 0, lockTrigger = 0, killTrigger = 0;
+time_t lastActivity = 0;
+
+time_t
+currentTime (void)
+{
+  return time ((time_t*) 0);
+}
+
+void
+handleEvent (Display* d, XEvent* event)
+{
+}
+
+/*
+ *  Benchmark parameters.
+ */
+static unsigned width    = 10;  /* children per window in the tree  */
+static unsigned depth    = 3;   /* levels in the tree               */
+static unsigned rate     = 100; /* windows created per second       */
+static unsigned lifetime = 500; /* milliseconds each of them lives  */
+static unsigned duration = 10;  /* seconds the storm lasts          */
+
+static unsigned long xErrors = 0; /* as it says */
+
+static int
+catchFalseAlarm (Display* d, XErrorEvent* event)
+{
+  ++xErrors;
+  return 0;
+}
+
+/*
+ *  Milliseconds since some arbitrary point in time.
+ */
+static double
+now (void)
+{
+  struct timeval tv;
+
+  (void) gettimeofday (&tv, 0);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+static double
+cpuTime (void)
+{
+  struct rusage usage;
+
+  (void) getrusage (RUSAGE_SELF, &usage);
+  return   usage.ru_utime.tv_sec * 1000.0 + usage.ru_utime.tv_usec / 1000.0
+         + usage.ru_stime.tv_sec * 1000.0 + usage.ru_stime.tv_usec / 1000.0;
+}
+
+/*
+ *  Build the static part of the window tree. One window out of four
+ *  asks for KeyPress events, just like real applications would, so
+ *  that diy.c gets to deal with those too.
+ */
+static unsigned long
+buildTree (Display* d, Window parent, unsigned level)
+{
+  unsigned long count = 0;
+  unsigned      i;
+  Window        window;
+
+  if (level == 0) return 0;
+
+  for (i = 0; i < width; ++i)
+  {
+    window = XCreateWindow (d, parent, 0, 0, 1, 1, 0, 0, InputOnly,
+                            CopyFromParent, 0, 0);
+    if (i % 4 == 0) (void) XSelectInput (d, window, KeyPressMask);
+    count += 1 + buildTree (d, window, level - 1);
+  }
+
+  return count;
+}
+
+/*
+ *  The storm itself. Windows are created below the root window at
+ *  the requested rate, and destroyed again after their lifetime.
+ *  Since they all live equally long, a ring buffer will do.
+ */
+static void
+storm (const char* displayName)
+{
+  Display* d;
+  Window   root;
+  Window*  ring;
+  double*  born;
+  unsigned size, head = 0, count = 0;
+  double   start, t;
+  unsigned long created = 0;
+
+  if (!(d = XOpenDisplay (displayName)))  /* = intended */
+  {
+    error0 ("Storm couldn't connect to the X server.\n");
+    exit (EXIT_FAILURE);
+  }
+
+  (void) XSetErrorHandler ((XErrorHandler) catchFalseAlarm);
+  root = DefaultRootWindow (d);
+  size = rate * (lifetime / 1000 + 1) + 1;
+  ring = newArray (Window, size);
+  born = newArray (double, size);
+  start = now ();
+
+  while ((t = now ()) < start + duration * 1000.0)
+  {
+    while (count && born[head] + lifetime <= t)
+    {
+      (void) XDestroyWindow (d, ring[head]);
+      head = (head + 1) % size;
+      --count;
+    }
+
+    while (created < (t - start) * rate / 1000.0 && count < size)
+    {
+      ring[(head + count) % size] =
+        XCreateWindow (d, root, 0, 0, 1, 1, 0, 0, InputOnly,
+                       CopyFromParent, 0, 0);
+      born[(head + count++) % size] = t;
+      ++created;
+    }
+
+    (void) XFlush (d);
+    (void) usleep (1000);
+  }
+
+  XCloseDisplay (d);
+  exit (EXIT_SUCCESS);
+}
+
+static void
+usage (const char* progName)
+{
+  error1 ("Usage: %s [-width n] [-depth n] [-rate n/s] [-lifetime ms]"
+          " [-duration s]\n", progName);
+  exit (EXIT_FAILURE);
+}
+
+int
+main (int argc, char* argv[])
+{
+  Display*      d;              /* the DIY code's connection      */
+  Display*      treeDisplay;    /* keeps the static tree alive    */
+  const char*   displayName;    /* as it says                     */
+  unsigned long nofWindows;     /* size of the static tree        */
+  unsigned long firstRequest;   /* request count before we start  */
+  unsigned long requests;       /* requests sent by diy.c         */
+  double        start, initDone, end, cpu;
+  pid_t         stormPid;
+  struct pollfd pfd;
+  diyStats      stats;
+  int           i;
+
+  for (i = 1; i < argc; ++i)
+  {
+    unsigned* target = 0;
+
+    if      (!strcmp (argv[i], "-width"))    target = &width;
+    else if (!strcmp (argv[i], "-depth"))    target = &depth;
+    else if (!strcmp (argv[i], "-rate"))     target = &rate;
+    else if (!strcmp (argv[i], "-lifetime")) target = &lifetime;
+    else if (!strcmp (argv[i], "-duration")) target = &duration;
+
+    if (!target || ++i == argc) usage (argv[0]);
+    *target = (unsigned) atoi (argv[i]);
+  }
+
+  displayName = getenv ("DISPLAY");
+
+  if (   !(d = XOpenDisplay (displayName))            /* = intended */
+      || !(treeDisplay = XOpenDisplay (displayName))) /* = intended */
+  {
+    error0 ("Couldn't connect to the X server.\n");
+    exit (EXIT_FAILURE);
+  }
+
+  (void) XSetErrorHandler ((XErrorHandler) catchFalseAlarm);
+  nofWindows = buildTree (treeDisplay, DefaultRootWindow (treeDisplay),
+                          depth);
+  (void) XSync (treeDisplay, False);
+
+ /*
+  *  The storm runs in a process of its own, so that it doesn't
+  *  show up in our CPU time.
+  */
+  if ((stormPid = fork ()) == 0) storm (displayName);
+  if (stormPid < 0)
+  {
+    error0 ("Couldn't fork the storm.\n");
+    exit (EXIT_FAILURE);
+  }
+
+  (void) XSync (d, False);
+  firstRequest = NextRequest (d);
+  cpu = cpuTime ();
+  start = now ();
+  initDiy (d);
+  initDone = now ();
+
+ /*
+  *  Keep going until the storm has passed and the queue has
+  *  drained completely.
+  */
+  pfd.fd = ConnectionNumber (d);
+  pfd.events = POLLIN;
+
+  for (;;)
+  {
+    (void) XFlush (d);
+    (void) poll (&pfd, 1, 10);
+    processEvents ();
+    getDiyStats (&stats);
+
+    if (   stormPid
+        && waitpid (stormPid, 0, WNOHANG) == stormPid)
+    {
+      stormPid = 0;
+    }
+
+    if (!stormPid && !XPending (d) && !stats.queueDepth) break;
+  }
+
+  end = now ();
+  cpu = cpuTime () - cpu;
+
+ /*
+  *  Our own XSync() accounts for one request.
+  */
+  (void) XSync (d, False);
+  requests = NextRequest (d) - firstRequest - 1;
+
+  (void) printf ("static windows      %lu\n", nofWindows);
+  (void) printf ("storm windows       %lu\n",
+                 (unsigned long) rate * duration);
+  (void) printf ("creation delay      %d s\n", CREATION_DELAY);
+  (void) printf ("initial walk        %.1f ms\n", initDone - start);
+  (void) printf ("full registration   %.1f ms\n", end - start);
+  (void) printf ("requests            %lu\n", requests);
+  (void) printf ("avoided requests    %lu\n", stats.avoidedRequests);
+  (void) printf ("round trips         %lu\n", stats.roundTrips);
+  (void) printf ("peak queue depth    %u\n", stats.queuePeak);
+  (void) printf ("peak queue memory   %lu bytes\n",
+                 (unsigned long) stats.peakBytes);
+  (void) printf ("X errors            %lu\n", xErrors);
+  (void) printf ("CPU time            %.1f ms (%.1f ms/s)\n",
+                 cpu, cpu * 1000.0 / (end - start));
+
+  XCloseDisplay (d);
+  XCloseDisplay (treeDisplay);
+  return EXIT_SUCCESS;
+}
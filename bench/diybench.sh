@@ -0,0 +1,22 @@
+#!/bin/sh
+#
+#  Runs diybench against a private Xvfb server, so that it can be used
+#  on a headless machine. Any arguments are passed on to diybench.
+#
+BENCH=${BENCH:-`dirname $0`/diybench}
+FIFO=`mktemp -u /tmp/diybench.XXXXXX`
+
+mkfifo $FIFO || exit 1
+Xvfb -displayfd 3 -nolisten tcp -screen 0 640x480x8 3>$FIFO 2>/dev/null &
+XVFB=$!
+trap 'kill $XVFB 2>/dev/null; rm -f $FIFO' 0 1 2 15
+
+read DPY <$FIFO
+
+if [ -z "$DPY" ]
+then
+  echo "Couldn't start Xvfb." >&2
+  exit 1
+fi
+
+DISPLAY=:$DPY "$BENCH" "$@"
@@ -0,0 +1,290 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It checks the
+ *          bookkeeping of the "do it yourself" approach (see diy.c): the
+ *          window hash table, with its backward shift deletion, and the
+ *          window queue, which is a ring buffer. It is not part of
+ *          xautolock itself, and doesn't need an X server. Since all of
+ *          it is static, it simply includes diy.c.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#include "../src/diy.c"
+
+/*
+ *  The bits of xautolock that diy.c relies upon.
+ */
+time_t lockTime = 0, killTime = 0, lockTrigger = 0, killTrigger = 0;
+time_t lastActivity = 0;
+
+time_t
+currentTime (void)
+{
+  return time ((time_t*) 0);
+}
+
+void
+handleEvent (Display* d, XEvent* event)
+{
+}
+
+static unsigned failures = 0; /* as it says */
+
+#define check(cond) \
+  do \
+  { \
+    if (!(cond)) \
+    { \
+      (void) fprintf (stderr, "diycheck: line %d: %s\n", __LINE__, #cond); \
+      ++failures; \
+    } \
+  } while (0)
+
+/*
+ *  Function for checking that no entry of the hash table sits behind
+ *  a hole in its probe sequence, and that the count is right. If an
+ *  entry did, lookups would no longer find it.
+ */
+static void
+checkTable (void)
+{
+  unsigned i, j, used = 0;
+
+  for (i = 0; i < windows.size; ++i)
+  {
+    if (!windows.slots[i].window) continue;
+
+    ++used;
+
+    for (j = hashWindow (windows.slots[i].window);
+         j != i;
+         j = (j + 1) & (windows.size - 1))
+    {
+      check (windows.slots[j].window != None);
+    }
+  }
+
+  check (used == windows.used);
+}
+
+/*
+ *  Function for finding a window that hashes to a given slot,
+ *  starting from some window id.
+ */
+static Window
+windowAt (unsigned slot, Window from)
+{
+  while (hashWindow (from) != slot) ++from;
+  return from;
+}
+
+static void
+resetTable (void)
+{
+  if (windows.slots) free (windows.slots);
+  windows.slots = 0;
+  windows.size = 0;
+  windows.used = 0;
+  growTable ();
+}
+
+/*
+ *  A cluster of colliding windows that wraps around the end of the
+ *  table. Deleting from it must shift the later ones back, past the
+ *  wrap, without disturbing windows that live there on their own.
+ */
+static void
+checkWrap (void)
+{
+  Window   w[6];
+  unsigned last;
+  int      i;
+
+  resetTable ();
+  last = windows.size - 1;
+
+  w[0] = windowAt (last - 1, 1);
+  w[1] = windowAt (last - 1, w[0] + 1);
+  w[2] = windowAt (last, 1);
+  w[3] = windowAt (last - 1, w[1] + 1);
+  w[4] = windowAt (0, 1);
+  w[5] = windowAt (1, 1);
+
+  for (i = 0; i < 6; ++i) setWindowState (w[i], WS_PENDING);
+  checkTable ();
+
+ /*
+  *  The cluster now runs from slot last - 1 up to and including
+  *  slot 3, with w[3] living on the far side of the wrap.
+  */
+  check (windows.slots[last - 1].window == w[0]);
+  check (windows.slots[last].window == w[1]);
+  check (windows.slots[0].window == w[2]);
+  check (windows.slots[1].window == w[3]);
+
+  forgetWindow (w[0]);
+  checkTable ();
+  check (windowState (w[0]) == WS_NONE);
+
+  for (i = 1; i < 6; ++i) check (windowState (w[i]) == WS_PENDING);
+
+  forgetWindow (w[2]);
+  checkTable ();
+  check (windowState (w[2]) == WS_NONE);
+  check (windowState (w[3]) == WS_PENDING);
+  check (windowState (w[4]) == WS_PENDING);
+  check (windowState (w[5]) == WS_PENDING);
+
+  setWindowState (w[4], WS_REGISTERED);
+  forgetWindow (w[1]);
+  forgetWindow (w[1]);
+  checkTable ();
+  check (windowState (w[3]) == WS_PENDING);
+  check (windowState (w[4]) == WS_REGISTERED);
+  check (windows.used == 3);
+}
+
+/*
+ *  Lots of windows, enough to make the table grow a couple of times,
+ *  with every third one dying again along the way.
+ */
+static void
+checkMany (void)
+{
+  const Window count = 5000;
+  Window       w;
+
+  resetTable ();
+
+  for (w = 1; w <= count; ++w)
+  {
+    setWindowState (w * 0x200001, w % 2 ? WS_PENDING : WS_REGISTERED);
+    if (w % 3 == 0) forgetWindow ((w - 1) * 0x200001);
+  }
+
+  checkTable ();
+
+  for (w = 1; w <= count; ++w)
+  {
+    if (w % 3 == 2 && w != count)
+    {
+      check (windowState (w * 0x200001) == WS_NONE);
+    }
+    else
+    {
+      check (windowState (w * 0x200001)
+             == (w % 2 ? WS_PENDING : WS_REGISTERED));
+    }
+  }
+}
+
+/*
+ *  Function for checking that the queue holds the given windows,
+ *  oldest first.
+ */
+static void
+checkQueue (const Window* expected, unsigned count)
+{
+  unsigned i;
+
+  check (queue.depth == count);
+
+  for (i = 0; i < count && i < queue.depth; ++i)
+  {
+    check (queue.items[(queue.head + i) % queue.size].window == expected[i]);
+  }
+}
+
+/*
+ *  Windows go into the queue in order of creation, and come out
+ *  once they're old enough. Let the ring buffer wrap, then fill
+ *  it up to the point where it has to grow while wrapped.
+ */
+static void
+checkRing (void)
+{
+  Window   expected[8];
+  unsigned i;
+
+  resetTable ();
+  free (queue.items);
+  queue.items = newArray (anItem, 4);
+  queue.size = 4;
+  queue.head = queue.depth = queue.peak = 0;
+
+  for (i = 0; i < 3; ++i)
+  {
+    queue.now = (time_t) i;
+    addToQueue ((Window) (100 + i));
+  }
+
+ /*
+  *  Windows that died, or were registered along with an ancestor,
+  *  leave the queue without costing any requests. Registered ones
+  *  don't get queued in the first place.
+  */
+  forgetWindow (100);
+  setWindowState (101, WS_REGISTERED);
+  queue.now = 2;
+  processQueue (0);
+  expected[0] = 102;
+  checkQueue (expected, 1);
+  check (queue.head == 2);
+
+  addToQueue (101);
+  check (windowState (101) == WS_REGISTERED);
+  checkQueue (expected, 1);
+
+  for (i = 3; i < 8; ++i)
+  {
+    queue.now = (time_t) i;
+    addToQueue ((Window) (100 + i));
+    expected[i - 2] = (Window) (100 + i);
+  }
+
+  check (queue.size == 8);
+  check (queue.peak == 6);
+  checkQueue (expected, 6);
+
+  for (i = 0; i < 6; ++i) forgetWindow (expected[i]);
+  queue.now = 7;
+  processQueue (2);
+  checkQueue (expected + 3, 3);
+
+  queue.now = 8;
+  processQueue (0);
+  checkQueue (expected, 0);
+}
+
+int
+main (int argc, char* argv[])
+{
+  queue.items = newArray (anItem, QUEUE_SIZE);
+  queue.size = QUEUE_SIZE;
+
+  checkWrap ();
+  checkMany ();
+  checkRing ();
+
+  if (failures)
+  {
+    (void) fprintf (stderr, "diycheck: %u failures\n", failures);
+    return EXIT_FAILURE;
+  }
+
+  (void) printf ("diycheck: all is well\n");
+  return EXIT_SUCCESS;
+}
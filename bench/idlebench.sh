@@ -0,0 +1,162 @@
+#!/bin/sh
+#
+#  Measures what an idle xautolock costs. For each mode, the real
+#  daemon is run against a private Xvfb server for a fixed period
+#  without any input, and its resource usage during that period is
+#  reported, scaled to one hour. Usage:
+#
+#    idlebench.sh [seconds] [extra xautolock options]
+#
+#  The modes are:
+#
+#    mit       MIT ScreenSaver extension (queryIdleTime ())
+#    diy       do it yourself approach (processEvents ())
+#    disabled  as mit, after xautolock -disable
+#    locked    as mit, with the locker running
+#
+#  Periods of an hour or more will have xautolock lock the screen.
+#
+#  Set MODES to run only some of them. Wakeups are voluntary context
+#  switches. X requests are only counted if xtrace is available, and
+#  syscalls are counted by strace if available (and allowed to attach);
+#  otherwise only the read and write calls are.
+#
+XAUTOLOCK=${XAUTOLOCK:-`dirname $0`/../xautolock}
+MODES=${MODES:-"mit diy disabled locked"}
+PERIOD=${1:-60}
+SETTLE=3
+[ $# -gt 0 ] && shift
+
+TMP=`mktemp -d /tmp/idlebench.XXXXXX` || exit 1
+HZ=`getconf CLK_TCK`
+XVFB=
+XTRACE=
+DAEMON=
+
+cleanup ()
+{
+  [ -n "$DAEMON" ] && pkill -P $DAEMON 2>/dev/null
+  kill $DAEMON $XTRACE $XVFB 2>/dev/null
+  wait 2>/dev/null
+  DAEMON= XTRACE= XVFB=
+}
+
+trap 'cleanup; rm -rf $TMP' 0
+trap 'exit 1' 1 2 15
+
+startServer ()
+{
+  mkfifo $TMP/fifo || exit 1
+  Xvfb -displayfd 3 -nolisten tcp -screen 0 640x480x8 \
+       3>$TMP/fifo 2>/dev/null &
+  XVFB=$!
+  read DPY <$TMP/fifo
+  rm -f $TMP/fifo
+
+  if [ -z "$DPY" ]
+  then
+    echo "Couldn't start Xvfb." >&2
+    exit 1
+  fi
+
+  DISPLAY=:$DPY
+  export DISPLAY
+}
+
+#
+#  Prints utime+stime (ticks), voluntary and involuntary context
+#  switches, read and write syscalls, and bytes read and written.
+#
+sample ()
+{
+  set -- `cut -d' ' -f14,15 /proc/$DAEMON/stat`
+  echo `expr $1 + $2` \
+       `awk '/^voluntary_ctxt/ {print $2}' /proc/$DAEMON/status` \
+       `awk '/^nonvoluntary_ctxt/ {print $2}' /proc/$DAEMON/status` \
+       `awk '/^syscr|^syscw|^rchar|^wchar/ {print $2}' /proc/$DAEMON/io`
+}
+
+requests ()
+{
+  if [ -n "$XTRACE" ]
+  then
+    grep -c ':<:' $TMP/xtrace 2>/dev/null
+  else
+    echo -
+  fi
+}
+
+runMode ()
+{
+  MODE=$1; shift
+  ARGS="-noclose -locker 'sleep 100000' -time 60"
+  [ $MODE = diy ] && ARGS="$ARGS -diy"
+
+  startServer
+
+  if which xtrace >/dev/null 2>&1
+  then
+    xtrace -n -d :$DPY -D :`expr $DPY + 100` -o $TMP/xtrace >/dev/null &
+    XTRACE=$!
+    sleep 1
+    (DISPLAY=:`expr $DPY + 100`; eval exec $XAUTOLOCK $ARGS '"$@"') &
+  else
+    (eval exec $XAUTOLOCK $ARGS '"$@"') &
+  fi
+
+  DAEMON=$!
+  sleep 1
+
+  case $MODE in
+    disabled) $XAUTOLOCK -disable ;;
+    locked)   $XAUTOLOCK -locknow ;;
+  esac
+
+  sleep $SETTLE
+  BEFORE=`sample`
+  REQUESTS=`requests`
+
+  if which strace >/dev/null 2>&1
+  then
+    timeout -s INT $PERIOD strace -c -f -p $DAEMON -o $TMP/strace \
+            2>/dev/null
+    SYSCALLS=`awk '/^100.00/ {print $4}' $TMP/strace 2>/dev/null`
+  else
+    sleep $PERIOD
+  fi
+
+  AFTER=`sample`
+  [ -n "$XTRACE" ] && REQUESTS=`expr \`requests\` - $REQUESTS`
+  RSS=`awk '/^VmRSS|^VmHWM/ {printf "%s ", $2}' /proc/$DAEMON/status`
+
+  #
+  #  Fields: 1 mode, 2-8 and 9-15 as in sample (), 16 requests,
+  #  17 syscalls, 18 rss, 19 hwm.
+  #
+  echo $MODE $BEFORE $AFTER $REQUESTS ${SYSCALLS:--} $RSS |
+  awk -v period=$PERIOD -v hz=$HZ '
+    function perHour(n) { return n * 3600 / period }
+    function maybe(n)   { return n == "-" ? "-" : sprintf ("%d", perHour(n)) }
+    {
+      printf "%-9s %9d %9d %9s %9s %9d %9d %7d %7d\n",
+             $1,
+             perHour($10 - $3),
+             perHour($9 - $2) * 1000 / hz,
+             maybe($16),
+             maybe($17),
+             perHour(($14 + $15) - ($7 + $8)),
+             perHour(($12 + $13) - ($5 + $6)),
+             $18, $19
+    }'
+  cleanup
+}
+
+echo "per hour, over $PERIOD seconds of idleness:"
+echo
+echo "mode        wakeups    cpu ms  requests  syscalls  rd+wr sc  io bytes" \
+     " rss kB  hwm kB"
+
+for MODE in $MODES
+do
+  runMode $MODE "$@"
+done
@@ -0,0 +1,270 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It checks the
+ *          table of corners and zones (see monitors.c): which areas a
+ *          given layout of monitors makes, and the grid used for finding
+ *          the one the pointer is in. It is not part of xautolock itself,
+ *          and doesn't need an X server. Since most of monitors.c is
+ *          static, it simply includes it. All it needs to know about the
+ *          display is how big its screens are, so it makes one up.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#define XLIB_ILLEGAL_ACCESS  /* for making up a display */
+
+#include "../src/monitors.c"
+
+/*
+ *  The bits of xautolock that monitors.c relies upon.
+ */
+time_t       cornerDelay = 0, cornerRedelay = 0;
+unsigned     cornerSize = 10;
+cornerAction corners[4] = {ca_forceLock, ca_dontLock,
+                           ca_dontLock, ca_forceLock};
+zone*        zones = 0;
+unsigned     nofZones = 0;
+unsigned     reloads = 0;
+
+/*
+ *  The made up display. Screen 0 is 1000x700, which doesn't fit the
+ *  grid, and screen 1 is exactly a single cell.
+ */
+static Display fake;
+static Screen  screens[2];
+
+/*
+ *  Zones, each with a delay of its own to tell them apart. The first
+ *  and the third overlap, as do the second and the lower right corner.
+ */
+static zone someZones[3] =
+{
+  {ca_dontLock,  50,  50, 200, 200, XValue | YValue | WidthValue
+                                  | HeightValue, 1, 0},
+  {ca_forceLock,  0,   0, 100,  50, XValue | YValue | XNegative
+                                  | YNegative | WidthValue
+                                  | HeightValue, 2, 0},
+  {ca_forceLock, 200, 200, 100, 100, XValue | YValue | WidthValue
+                                  | HeightValue, 3, 0},
+};
+
+/*
+ *  Screen 0 is spread across two monitors. The right one is smaller,
+ *  and sits against the right edge of the left one, which hides the
+ *  corners they have in common.
+ */
+static XRectangle monitors[2] =
+{
+  {  0,   0, 600, 700},
+  {600, 100, 400, 500},
+};
+
+static unsigned failures = 0; /* as it says */
+
+#define check(cond) \
+  do \
+  { \
+    if (!(cond)) \
+    { \
+      (void) fprintf (stderr, "monitorcheck: line %d: %s\n", \
+                      __LINE__, #cond); \
+      ++failures; \
+    } \
+  } while (0)
+
+/*
+ *  What a position on a screen ought to be in: an action (or -1 for
+ *  nothing at all) and a delay.
+ */
+static const struct
+{
+  int screen;
+  int x;
+  int y;
+  int action;
+  int delay;
+} lookups[] =
+{
+  /* off the screen */
+  {0,   -1,    0, -1, 0},
+  {0,    0,   -1, -1, 0},
+  {0, 1000,  100, -1, 0},
+  {0,    0,  700, -1, 0},
+  {1,   64,    0, -1, 0},
+  {1,    0,   64, -1, 0},
+
+  /* the corners of the left monitor, and right next to them */
+  {0,    0,    0, ca_forceLock, 0},
+  {0,   10,   10, ca_forceLock, 0},
+  {0,   11,   10, -1, 0},
+  {0,   10,   11, -1, 0},
+  {0,  599,    0, ca_dontLock, 0},
+  {0,  589,   10, ca_dontLock, 0},
+  {0,  588,    0, -1, 0},
+  {0,    0,  699, ca_dontLock, 0},
+  {0,  599,  699, ca_forceLock, 0},
+
+  /* those of the right one, where they can be reached */
+  {0,  600,  100, -1, 0},
+  {0,  600,  599, -1, 0},
+  {0,  999,  100, ca_dontLock, 0},
+  {0,  989,  110, ca_dontLock, 0},
+  {0,  999,   99, -1, 0},
+  {0,  999,  599, ca_forceLock, 0},
+  {0,  999,  600, -1, 0},
+  {0,  999,  699, -1, 0},
+
+  /* zones across cell boundaries, relative to each monitor */
+  {0,   50,   50, ca_dontLock, 1},
+  {0,   63,   63, ca_dontLock, 1},
+  {0,   64,   64, ca_dontLock, 1},
+  {0,  127,  128, ca_dontLock, 1},
+  {0,  249,  249, ca_dontLock, 1},
+  {0,   49,   50, -1, 0},
+  {0,  650,  150, ca_dontLock, 1},
+  {0,  849,  349, ca_dontLock, 1},
+  {0,  850,  349, ca_forceLock, 3},
+  {0,  900,  349, -1, 0},
+  {1,   51,   51, ca_dontLock, 1},
+
+  /* the first one added wins */
+  {0,  200,  200, ca_dontLock, 1},
+  {0,  250,  250, ca_forceLock, 3},
+  {0,  299,  299, ca_forceLock, 3},
+  {0,  300,  299, -1, 0},
+  {0,  500,  650, ca_forceLock, 2},
+  {0,  588,  699, ca_forceLock, 2},
+  {0,  589,  689, ca_forceLock, 0},
+  {0,  960,  589, ca_forceLock, 2},
+  {0,  989,  589, ca_forceLock, 0},
+  {1,   60,   60, ca_forceLock, 0},
+  {1,   63,    0, ca_dontLock, 0},
+};
+
+static void
+makeDisplay (void)
+{
+  fake.nscreens = 2;
+  fake.screens = screens;
+
+  screens[0].display = &fake;
+  screens[0].width = 1000;
+  screens[0].height = 700;
+  screens[1].display = &fake;
+  screens[1].width = 64;
+  screens[1].height = 64;
+}
+
+/*
+ *  Function for looking up a position, and checking that it gives
+ *  what it should.
+ */
+static Bool
+lookup (int screen, int x, int y, int action, int delay)
+{
+  zoneBox found; /* as it says */
+
+  if (!whichZone (&fake, &screens[screen], x, y, &found))
+  {
+    return action < 0;
+  }
+
+  return    (int) found.action == action
+         && found.delay == delay
+         && found.screen == screen
+         && x >= found.left && x <= found.right
+         && y >= found.top && y <= found.bottom;
+}
+
+/*
+ *  Build the table from the monitors above, as buildTable () would if
+ *  RandR had told us about them.
+ */
+static void
+checkLayout (void)
+{
+  XRectangle whole; /* as it says   */
+  unsigned   i;     /* loop counter */
+
+  zones = someZones;
+  nofZones = 3;
+
+  table.nofBoxes = 0;
+  table.smallest = -1;
+  addMonitors (0, monitors, 2);
+  whole.x = whole.y = 0;
+  whole.width = whole.height = 64;
+  addMonitors (1, &whole, 1);
+  buildGrid (&fake);
+  table.built = True;
+  table.builtSize = cornerSize;
+  table.reloaded = reloads;
+
+  check (smallestMonitor (&fake) == 64);
+
+  for (i = 0; i < sizeof (lookups) / sizeof (lookups[0]); ++i)
+  {
+    if (!lookup (lookups[i].screen, lookups[i].x, lookups[i].y,
+                 lookups[i].action, lookups[i].delay))
+    {
+      (void) fprintf (stderr, "monitorcheck: wrong zone at %d,%d of %d\n",
+                      lookups[i].x, lookups[i].y, lookups[i].screen);
+      ++failures;
+    }
+  }
+}
+
+/*
+ *  Reloading the settings rebuilds the table, and without RandR each
+ *  screen counts as a single monitor. So do bigger corners.
+ */
+static void
+checkRebuild (void)
+{
+  zones = 0;
+  nofZones = 0;
+  ++reloads;
+
+  check (lookup (0, 600, 100, -1, 0));
+  check (lookup (0, 999, 0, ca_dontLock, 0));
+  check (lookup (0, 999, 699, ca_forceLock, 0));
+  check (lookup (0, 599, 699, -1, 0));
+  check (lookup (0, 50, 50, -1, 0));
+  check (smallestMonitor (&fake) == 64);
+
+  cornerSize = 100;
+  check (lookup (0, 100, 100, ca_forceLock, 0));
+  check (lookup (0, 101, 100, -1, 0));
+  check (lookup (0, 899, 0, ca_dontLock, 0));
+  check (lookup (1, 32, 32, ca_forceLock, 0));
+  check (table.builtSize == 100);
+}
+
+int
+main (int argc, char* argv[])
+{
+  makeDisplay ();
+  checkLayout ();
+  checkRebuild ();
+
+  if (failures)
+  {
+    (void) fprintf (stderr, "monitorcheck: %u failures\n", failures);
+    return EXIT_FAILURE;
+  }
+
+  (void) printf ("monitorcheck: all is well\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It checks the
+ *          way -noshell splits commands into arguments (see options.c).
+ *          It is not part of xautolock itself, and doesn't need an X
+ *          server. Since splitCommand () is static, it simply includes
+ *          options.c.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#include "../src/options.c"
+
+/*
+ *  The bits of xautolock that options.c relies upon.
+ */
+const char* progName = "splitcheck";
+char**      argArray = 0;
+
+int
+smallestMonitor (Display* d)
+{
+  return -1;
+}
+
+#ifdef HasPosixSpawn
+/*
+ *  Each command comes with the arguments it should be split into,
+ *  or with none at all if it needs a shell.
+ */
+#define MAX_ARGS 5
+
+static const struct
+{
+  const char* command;
+  const char* args[MAX_ARGS + 1];
+} cases[] =
+{
+  /* plain words, with all sorts of white space around them */
+  { "xlock -mode blank",          { "xlock", "-mode", "blank" } },
+  { "  xlock \t -nolock",         { "xlock", "-nolock" } },
+  { "xlock -nolock  ",            { "xlock", "-nolock" } },
+  { "xlock\t",                    { "xlock" } },
+  { "xlock",                      { "xlock" } },
+
+  /* quotes */
+  { "xlock 'a b' \"c\td\"",       { "xlock", "a b", "c\td" } },
+  { "xlock a'b'\"c\"d",           { "xlock", "abcd" } },
+  { "xlock \"it's\" 'say \"hi\"'",{ "xlock", "it's", "say \"hi\"" } },
+  { "xlock '$HOME' '*' ';'",      { "xlock", "$HOME", "*", ";" } },
+  { "xlock 'unterminated",        { 0 } },
+  { "xlock \"unterminated",       { 0 } },
+
+  /* empty arguments */
+  { "xlock '' \"\" x",            { "xlock", "", "", "x" } },
+  { "xlock ''",                   { "xlock", "" } },
+  { "''",                         { "" } },
+  { "",                           { 0 } },
+  { " \t ",                       { 0 } },
+
+  /* backslashes, which only mean nothing between single quotes */
+  { "xlock 'a\\b'",               { "xlock", "a\\b" } },
+  { "xlock a\\ b",                { 0 } },
+  { "xlock \"a\\b\"",             { 0 } },
+  { "xlock \\",                   { 0 } },
+
+  /* anything else a shell would do something with */
+  { "xlock; beep",                { 0 } },
+  { "xlock $HOME",                { 0 } },
+  { "xlock \"$HOME\"",            { 0 } },
+  { "xlock *",                    { 0 } },
+  { "xlock ~/x",                  { 0 } },
+  { "xlock #comment",             { 0 } },
+  { "xlock a#b a~b",              { "xlock", "a#b", "a~b" } },
+  { "FOO=bar xlock",              { 0 } },
+  { "xlock a=b",                  { "xlock", "a=b" } },
+};
+
+static Bool
+checkCase (const char* command, const char* const* expected)
+{
+  char** argv = splitCommand (command);
+  int    i;
+  Bool   ok = True;
+
+  if (!argv || !expected[0]) return !argv && !expected[0];
+
+  for (i = 0; expected[i] && argv[i]; ++i)
+  {
+    if (strcmp (expected[i], argv[i])) ok = False;
+  }
+
+  if (expected[i] || argv[i]) ok = False;
+
+  free (argv[0]);
+  free (argv);
+  return ok;
+}
+#endif /* HasPosixSpawn */
+
+int
+main (int argc, char* argv[])
+{
+#ifdef HasPosixSpawn
+  unsigned i, failures = 0;
+
+  for (i = 0; i < sizeof (cases) / sizeof (cases[0]); ++i)
+  {
+    if (!checkCase (cases[i].command, cases[i].args))
+    {
+      (void) fprintf (stderr, "splitcheck: wrong split of <%s>\n",
+                      cases[i].command);
+      ++failures;
+    }
+  }
+
+  if (failures)
+  {
+    (void) fprintf (stderr, "splitcheck: %u failures\n", failures);
+    return EXIT_FAILURE;
+  }
+
+  (void) printf ("splitcheck: all is well\n");
+#else /* HasPosixSpawn */
+  (void) printf ("splitcheck: nothing to check without HasPosixSpawn\n");
+#endif /* HasPosixSpawn */
+
+  return EXIT_SUCCESS;
+}
@@ -34,13 +34,54 @@
 #include <time.h>
 #include <signal.h>
 #include <ctype.h>
+#include <errno.h>
 #include <sys/types.h>
 
 #ifndef VMS
 #include <pwd.h>
 #include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <dirent.h>
 #endif /* VMS */
 
+#ifdef __linux__
+#include <sys/syscall.h>     /* Needed for pidfd_open () */
+#endif /* __linux__ */
+
+#ifdef HasPoll
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <setjmp.h>
+#endif /* HasPoll */
+
+#ifdef HasBoottime
+#include <sys/timerfd.h>
+#endif /* HasBoottime */
+
+#ifdef HasPosixSpawn
+#include <spawn.h>
+#endif /* HasPosixSpawn */
+
+#ifdef HasInotify
+#include <sys/inotify.h>
+#endif /* HasInotify */
+
+#ifdef HasMmap
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif /* HasMmap */
+
 #ifdef VMS
 #define HasVFork
 #include <descrip.h>
@@ -67,6 +108,22 @@
 #include <X11/extensions/scrnsaver.h>
 #endif /* HasScreenSaver */
 
+#ifdef HasSync
+#include <X11/extensions/sync.h>
+#endif /* HasSync */
+
+#ifdef HasXInput2
+#include <X11/extensions/XInput2.h>
+#endif /* HasXInput2 */
+
+#ifdef HasXcb
+#include <X11/Xlib-xcb.h>
+#endif /* HasXcb */
+
+#ifdef HasXrandr
+#include <X11/extensions/Xrandr.h>
+#endif /* HasXrandr */
+
 #ifndef HasVFork
 #define vfork           fork
 #endif /* HasVFork */
@@ -84,12 +141,17 @@
 #define KILL_MINS         20          /* default ...                       */
 #define MAX_KILL_MINS     120         /* maximum ...                       */
 
+#ifndef CREATION_DELAY
 #define CREATION_DELAY    30          /* should be > 10 and
                                          < min(45,(MIN_LOCK_MINS*30))      */
+#endif /* CREATION_DELAY */
 #define CORNER_SIZE       10          /* size in pixels of the
                                          force-lock areas                  */
 #define CORNER_DELAY      5           /* number of seconds to wait
                                          before forcing a lock             */
+#define JOURNAL_IDLE      5           /* shortest idle stretch worth
+                                         writing down (see -journal) or
+                                         counting (see -stats)             */
 
 #ifdef VMS
 #define SLOW_VMS_DELAY    15          /* explained in VMS.NOTES file       */
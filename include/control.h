@@ -0,0 +1,39 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It declares
+ *          the stuff used for controlling a running xautolock through
+ *          a Unix domain socket.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#ifndef __control_h
+#define __control_h
+
+#include "config.h"
+
+#define MAX_CONTROL_FDS  9  /* listening socket plus clients */
+
+extern Bool runtimePath (Display* d, const char* suffix, char* path,
+                         size_t size);
+extern void initControl (Display* d);
+extern void processControl (Display* d);
+extern Bool sendControlMessage (Display* d);
+
+#ifdef HasPoll
+extern int addControlFds (struct pollfd* fds);
+#endif /* HasPoll */
+
+#endif /* __control_h */
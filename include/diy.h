@@ -25,7 +25,21 @@
 
 #include "config.h"
 
+typedef struct
+{
+  unsigned      queueDepth;      /* windows waiting in the queue    */
+  unsigned      queuePeak;       /* maximum queueDepth so far       */
+  unsigned      windows;         /* windows being kept track of     */
+  unsigned long requests;        /* requests sent to the server     */
+  unsigned long avoidedRequests; /* requests saved by not processing
+                                    dead or known windows           */
+  unsigned long roundTrips;      /* times we waited for the server  */
+  size_t        peakBytes;       /* maximum memory used for the
+                                    queue and the window table      */
+} diyStats;
+
 extern void initDiy (Display* d);
 extern void processEvents (void);
+extern void getDiyStats (diyStats* stats);
 
 #endif /* diy_h */
@@ -22,9 +22,49 @@
 #define __engine_h
 
 #include "config.h"
+#include "monitors.h"
 
-extern void queryPointer (Display* d);
+/*
+ *  What the engine remembers about a display from one call to the
+ *  next. See session.c for why anyone else would want to know.
+ */
+typedef struct
+{
+  time_t    prevQuery;
+  time_t    idleFrom;
+  time_t    idleSeen;
+  Window    pointerRoot;
+  Screen*   pointerScreen;
+  unsigned  prevMask;
+  int       prevRootX;
+  int       prevRootY;
+  Bool      firstCall;
+  Bool      pointerEvents;
+  Bool      pointerMoved;
+  Bool      inZone;
+  zoneBox   pointerZone;
+  unsigned  zonesReloaded;
+  Bool      useRedelay;
+  time_t    prevNotification;
+  time_t    journaledActivity;
+  double    lockDecided;
+  long*     rootMasks;
+  Bool      watchingRoots;
+  unsigned  nofOtherChildren;
+} engineState;
+
+extern void handleEvent (Display* d, XEvent* event);
+extern Bool queryPointer (Display* d);
+extern void usePointerEvents (void);
+extern void notePointerMotion (void);
 extern void queryIdleTime (Display* d, Bool useXidle);
+extern void processIdleTime (Time idleTime, Bool watched);
 extern void evaluateTriggers (Display* d);
+extern time_t timeToNextTrigger (void);
+extern Bool awaitingLocker (void);
+extern Bool reloadSettings (Display* d);
+extern void saveEngineState (engineState* s);
+extern void loadEngineState (const engineState* s);
+extern void initEngineState (engineState* s);
 
 #endif /* engine_h */
@@ -0,0 +1,40 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It declares
+ *          the stuff used for keeping track of how things (like the
+ *          time it takes to lock the screen) are distributed.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#ifndef __histogram_h
+#define __histogram_h
+
+#include "config.h"
+
+#define HISTOGRAM_SUB      8                     /* buckets per power of 2 */
+#define HISTOGRAM_BUCKETS  (32 * HISTOGRAM_SUB)  /* as it says             */
+
+typedef struct
+{
+  unsigned long counts[HISTOGRAM_BUCKETS]; /* as it says                */
+  unsigned long total;                     /* number of values added    */
+  long          max;                       /* largest value added       */
+} histogram;
+
+extern void addToHistogram (histogram* h, long value);
+extern long histogramPercentile (const histogram* h, unsigned percent);
+
+#endif /* __histogram_h */
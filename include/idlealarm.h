@@ -0,0 +1,31 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It declares
+ *          the stuff used when the program lets the SYNC extension
+ *          tell it about user (in)activity instead of asking for it.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#ifndef __idlealarm_h
+#define __idlealarm_h
+
+#include "config.h"
+
+extern Bool initIdleAlarms (Display* d);
+extern void processAlarms (Display* d);
+extern void refreshIdleTime (Display* d);
+
+#endif /* __idlealarm_h */
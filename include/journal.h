@@ -0,0 +1,77 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It declares
+ *          the stuff used for keeping a journal of what happened (see
+ *          -journal).
+ *
+ *          Like statuspage.h, this file can be included on its own by
+ *          programs that want to read the journal (see tools/xajournal.c
+ *          for an example). A journal consists of a header, followed by
+ *          any number of records. All numbers are in the byte order of
+ *          the machine that wrote them. Future versions will only ever
+ *          add record types.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#ifndef __journal_h
+#define __journal_h
+
+#include <stdint.h>
+
+#define JOURNAL_MAGIC    "XAJ\n"  /* as it says */
+#define JOURNAL_VERSION  1        /* as it says */
+
+typedef enum
+{
+  jr_activity = 1, /* user activity after being idle for value seconds */
+  jr_notify,       /* notified value seconds before locking            */
+  jr_lock,         /* started the locker, which has value as its pid   */
+  jr_unlock,       /* locker exited with status value (128 + signal if
+                      killed, -1 if unknown)                          */
+  jr_kill,         /* started the killer                               */
+  jr_disable,      /* got disabled                                     */
+  jr_enable,       /* got enabled                                      */
+  jr_sleep,        /* the machine slept for value seconds              */
+  jr_lost          /* value records got lost for lack of room          */
+} journalType;
+
+typedef struct
+{
+  char             magic[4];      /* JOURNAL_MAGIC                */
+  uint32_t         version;       /* JOURNAL_VERSION              */
+  uint32_t         recordSize;    /* sizeof (journalRecord)       */
+  uint32_t         reserved;      /* as it says                   */
+} journalHeader;
+
+typedef struct
+{
+  int64_t          time;          /* microseconds since the epoch */
+  uint16_t         type;          /* see journalType              */
+  int16_t          display;       /* display number, or -1        */
+  int32_t          value;         /* see journalType              */
+} journalRecord;
+
+/*
+ *  The rest is for xautolock itself.
+ */
+#ifdef __config_h
+extern void initJournal (void);
+extern void journalDisplay (const char* name);
+extern void journal (journalType type, long value);
+extern void flushJournal (Bool now);
+#endif /* __config_h */
+
+#endif /* __journal_h */
@@ -22,8 +22,28 @@
 #define __message_h
 
 #include "config.h"
+#include "options.h"
 
-extern void checkConnectionAndSendMessage (Display* d);
-extern void lookForMessages (Display* d);
+/*
+ *  Older senders still drop their message in a property on the root
+ *  window of the first screen. Whoever selects events on that root
+ *  must keep this in the mask, or those messages go unnoticed.
+ */
+#define LEGACY_MESSAGE_MASK PropertyChangeMask
+
+typedef struct
+{
+  Atom semaphore;
+  Atom messageAtom;
+  Atom windowAtom;
+} messageState;
+
+extern void checkConnectionAndSendMessage (Display* d, Window ourWin);
+extern Bool claimDisplay (Display* d, Window ourWin);
+extern void releaseDisplay (Display* d);
+extern void saveMessageState (messageState* s);
+extern void loadMessageState (const messageState* s);
+extern Bool processMessage (Display* d, XEvent* event);
+extern Bool actOnMessage (Display* d, message msg);
 
 #endif /* __message_h */
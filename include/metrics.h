@@ -0,0 +1,63 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It declares
+ *          the stuff used for serving metrics to monitoring systems
+ *          (see -metrics).
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#ifndef __metrics_h
+#define __metrics_h
+
+#include "config.h"
+
+#define MAX_METRICS_FDS  6  /* listening sockets plus clients */
+
+/*
+ *  The DIY code keeps its own counts (see diy.h), so that it can
+ *  be benchmarked on its own.
+ */
+typedef enum
+{
+  xs_message,      /* message.c */
+  xs_engine,       /* engine.c  */
+  nofXSubsystems   /* as it says */
+} xSubsystem;
+
+typedef struct
+{
+  unsigned long requests[nofXSubsystems];   /* X requests sent           */
+  unsigned long roundTrips[nofXSubsystems]; /* ... waited for a reply    */
+  unsigned long wakeups;                    /* main loop iterations      */
+  unsigned long lockerSpawns;               /* lockers started           */
+  unsigned long spawnFailures;              /* lockers that wouldn't     */
+  double        spawnSeconds;               /* total time to start them  */
+} metricCounters;
+
+extern metricCounters metrics;
+
+#define countRequests(sub,n)  (metrics.requests[sub] += (n))
+#define countRoundTrip(sub)   (++metrics.requests[sub],                    \
+                               ++metrics.roundTrips[sub])
+
+extern void initMetrics (Display* d);
+extern void processMetrics (Display* d);
+
+#ifdef HasPoll
+extern int addMetricsFds (struct pollfd* fds);
+#endif /* HasPoll */
+
+#endif /* __metrics_h */
@@ -0,0 +1,80 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It declares
+ *          the stuff used for finding out where the corners (and other
+ *          zones) of the monitors are.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#ifndef __monitors_h
+#define __monitors_h
+
+#include "config.h"
+#include "options.h"
+
+#define GRID_CELL  64  /* pixels along each side of a grid cell */
+
+typedef struct
+{
+  int          screen;   /* screen number                  */
+  int          left;     /* first column of the zone       */
+  int          top;      /* first row of the zone          */
+  int          right;    /* last column of the zone        */
+  int          bottom;   /* last row of the zone           */
+  cornerAction action;   /* as it says                     */
+  time_t       delay;    /* see options.h                  */
+  time_t       redelay;  /* ditto                          */
+} zoneBox;
+
+typedef struct
+{
+  unsigned     first;    /* index of its first cell        */
+  int          columns;  /* as it says                     */
+  int          rows;     /* as it says                     */
+  int          width;    /* of the screen, when last built */
+  int          height;   /* ditto                          */
+} screenGrid;
+
+/*
+ *  What we know about the monitors of a display. See session.c for
+ *  why anyone else would want to know.
+ */
+typedef struct
+{
+  Bool        useRandr;   /* whether the server has RandR 1.3+    */
+  int         eventBase;  /* of the RandR extension               */
+  Bool        built;      /* whether the boxes are up to date     */
+  unsigned    builtSize;  /* cornerSize they were built for       */
+  unsigned    reloaded;   /* value of reloads they were built for */
+  zoneBox*    boxes;      /* as it says                           */
+  unsigned    nofBoxes;   /* as it says                           */
+  unsigned    maxBoxes;   /* room in the above                    */
+  int         smallest;   /* smallest monitor width or height     */
+  screenGrid* grids;      /* one per screen                       */
+  unsigned*   cells;      /* where each cell's boxes start        */
+  unsigned*   cellBoxes;  /* boxes overlapping each cell          */
+} monitorState;
+
+extern void initMonitors (Display* d);
+extern Bool whichZone (Display* d, Screen* screen, int rootX, int rootY,
+                       zoneBox* found);
+extern int  smallestMonitor (Display* d);
+extern Bool processMonitorEvent (XEvent* event);
+extern void saveMonitorState (monitorState* s);
+extern void loadMonitorState (const monitorState* s);
+extern void freeMonitorState (monitorState* s);
+
+#endif /* __monitors_h */
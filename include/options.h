@@ -30,6 +30,22 @@ typedef enum
   ca_forceLock   /* lock immediately */
 } cornerAction;
 
+/*
+ *  An area of the screen in which the pointer acts like it does in
+ *  a corner. Its geometry is relative to each monitor.
+ */
+typedef struct
+{
+  cornerAction action;  /* as it says                          */
+  int          x;       /* as returned by XParseGeometry ()    */
+  int          y;       /* ditto                               */
+  unsigned     width;   /* ditto                               */
+  unsigned     height;  /* ditto                               */
+  int          mask;    /* ditto                               */
+  time_t       delay;   /* like cornerDelay, but for this zone */
+  time_t       redelay; /* ditto for cornerRedelay             */
+} zone;
+
 typedef enum
 {
   msg_none,      /* as it says                           */
@@ -40,21 +56,32 @@ typedef enum
   msg_lockNow,   /* tell running xautolock to lock now   */
   msg_unlockNow, /* tell running xautolock to unlock now */
   msg_restart,   /* tell running xautolock to restart    */
+  msg_status,    /* ask a running xautolock how it is    */
+  msg_stats,     /* ask a running xautolock how it went  */
+  msg_reload,    /* tell running xautolock to reload     */
 } message;
 
 /*
  *  Global option settings. Documented in options.c. 
  *  Do not modify any of these from outside that file.
  */
-extern const char   *locker, *nowLocker, *notifier, *killer;
+extern const char   *locker, *nowLocker, *notifier, *killer, *displayList,
+                    *journalFile;
 extern time_t       lockTime, killTime, notifyMargin,
                     cornerDelay, cornerRedelay;
-extern int          bellPercent;
+extern int          bellPercent, metricsPort;
 extern unsigned     cornerSize;
 extern Bool         secure, notifyLock, useRedelay, resetSaver, 
-                    noCloseOut, noCloseErr, detectSleep;
+                    noCloseOut, noCloseErr, detectSleep, tickless,
+                    forceDiy, noShell, warmLocker, writeStatus,
+                    serveMetrics;
+extern char         **lockerArgv, **nowLockerArgv, **notifierArgv,
+                    **killerArgv;
 extern cornerAction corners[4];
+extern zone         *zones;
+extern unsigned     nofZones;
 extern message      messageToSend; 
+extern unsigned     reloads;
 
 extern Bool         killerSpecified, notifierSpecified;
 
@@ -64,5 +91,6 @@ extern int                   vmsStatus;
 #endif /* VMS */
 
 extern void processOpts (Display* d, int argc, char* argv[]);
+extern Bool reloadOpts (Display* d);
 
 #endif /* options.h */
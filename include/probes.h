@@ -0,0 +1,58 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It defines
+ *          the static tracepoints that tools like bpftrace and perf can
+ *          attach to, e.g.
+ *
+ *            bpftrace -e 'usdt:./xautolock:xautolock:idle_query
+ *                         { printf ("%d ms\n", arg0); }'
+ *
+ *          Without HasSdt, they compile to nothing at all, arguments
+ *          included. With it, each of them is a single nop until some
+ *          tracer comes along. The probes are:
+ *
+ *            idle_query     (idle ms)
+ *            pointer_query  (x, y, zone action or -1)
+ *            reset_triggers ()
+ *            notify         (seconds until the lock)
+ *            lock           (whether we were told to)
+ *            kill           ()
+ *            locker_spawn   (pid, microseconds it took)
+ *            locker_reap    (pid, exit code, 128 + signal or -1)
+ *            message        (message number, see options.h)
+ *            select_events  (window, substructure only)
+ *            add_to_queue   (window, queue depth)
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#ifndef __probes_h
+#define __probes_h
+
+#ifdef HasSdt
+#include <sys/sdt.h>
+
+#define probe0(name)        DTRACE_PROBE (xautolock, name)
+#define probe1(name,a)      DTRACE_PROBE1 (xautolock, name, a)
+#define probe2(name,a,b)    DTRACE_PROBE2 (xautolock, name, a, b)
+#define probe3(name,a,b,c)  DTRACE_PROBE3 (xautolock, name, a, b, c)
+#else /* HasSdt */
+#define probe0(name)
+#define probe1(name,a)
+#define probe2(name,a,b)
+#define probe3(name,a,b,c)
+#endif /* HasSdt */
+
+#endif /* __probes_h */
@@ -0,0 +1,63 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It declares
+ *          the stuff used for watching more than one display at once.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#ifndef __session_h
+#define __session_h
+
+#include "config.h"
+#include "state.h"
+#include "engine.h"
+#include "message.h"
+#include "monitors.h"
+#include "statuspage.h"
+#include "stats.h"
+
+typedef struct
+{
+  char*          name;        /* display name, e.g. ":3"               */
+  Display*       display;     /* connection, or 0 if not open          */
+  Bool           useXidle;    /* whether to ask Xidle rather than MIT  */
+  Bool           pollPointer; /* whether to look every second anyway   */
+  Bool           retired;     /* whether we were told to go away       */
+  Bool           gone;        /* whether the display has disappeared   */
+  Bool           seen;        /* whether it was there at the last scan */
+  unsigned       reloaded;    /* value of reloads last applied to it   */
+  time_t         due;         /* when to look after it next            */
+  unsigned       slot;        /* position in the deadline heap         */
+  displayState   state;       /* see state.h                           */
+  engineState    engine;      /* see engine.h                          */
+  messageState   message;     /* see message.h                         */
+  monitorState   monitors;    /* see monitors.h                        */
+  statusFile*    status;      /* see statuspage.h                      */
+  activityStats* stats;       /* see stats.h                           */
+} session;
+
+extern session** sessions;
+extern unsigned  nofSessions;
+
+extern void initSessions (const char* list);
+extern void enterSession (session* s);
+extern void leaveSession (session* s);
+extern void scheduleSession (session* s, time_t due);
+extern void dropSession (session* s);
+extern int  watchDisplays (void);
+extern void scanDisplays (void);
+
+#endif /* __session_h */
@@ -22,6 +22,8 @@
 #define __state_h
 
 #include "config.h"
+#include "histogram.h"
+#include "probes.h"
 
 extern const char* progName;
 extern char**      argArray;
@@ -31,15 +33,52 @@ extern Bool        lockNow;
 extern Bool        unlockNow;
 extern time_t      lockTrigger;
 extern time_t      killTrigger;
+extern time_t      lastActivity;
 extern pid_t       lockerPid;
+extern Bool        leave;
+extern int         lockerFd;
+extern unsigned long xErrors;
+extern long        lockLatency;
+extern double      lockRequested;
+extern histogram*  lockHistogram;
 
-#define setLockTrigger(delta) (lockTrigger = time ((time_t*) 0) + (delta))
-#define setKillTrigger(delta) (killTrigger = time ((time_t*) 0) + (delta))
+/*
+ *  The part of the above that belongs to a display rather than to
+ *  the process as a whole. In multi-display mode (see session.c),
+ *  each display has one of these, and the right one gets loaded
+ *  into the variables above whenever that display is being looked
+ *  after.
+ */
+typedef struct
+{
+  Bool        disabled;
+  Bool        lockNow;
+  Bool        unlockNow;
+  Bool        leave;
+  time_t      lockTrigger;
+  time_t      killTrigger;
+  time_t      lastActivity;
+  pid_t       lockerPid;
+  int         lockerFd;
+  double      lockRequested;
+  long        lockLatency;
+  histogram*  lockHistogram;
+} displayState;
+
+#define setLockTrigger(delta) (lockTrigger = currentTime () + (delta))
+#define setKillTrigger(delta) (killTrigger = currentTime () + (delta))
 #define disableKillTrigger()  (killTrigger = 0)
+#define noteActivity()        (lastActivity = currentTime ())
 #define resetLockTrigger()    setLockTrigger (lockTime);
-#define resetTriggers()       setLockTrigger (lockTime);                   \
+#define resetTriggers()       probe0 (reset_triggers);                     \
+                              setLockTrigger (lockTime);                   \
                               if (killTrigger) setKillTrigger (killTime);  \
 
 extern void initState (int argc, char* argv[]);
+extern time_t currentTime (void);
+extern time_t timeAsleep (void);
+extern double preciseTime (void);
+extern void saveState (displayState* s);
+extern void loadState (const displayState* s);
 
 #endif /* __state_h */
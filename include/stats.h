@@ -0,0 +1,47 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It declares
+ *          the stuff used for keeping running statistics about user
+ *          activity and locking (see -stats).
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#ifndef __stats_h
+#define __stats_h
+
+#include "config.h"
+
+typedef enum
+{
+  ls_timeout,    /* the lock trigger went off        */
+  ls_corner,     /* the pointer sat in a `+' corner  */
+  ls_lockNow,    /* we were told to lock (-locknow)  */
+  nofLockSources /* as it says                       */
+} lockSource;
+
+typedef struct activityStats activityStats; /* see stats.c */
+
+extern activityStats* newStats (const char* name);
+extern void freeStats (activityStats* s);
+extern void loadStats (activityStats* s);
+extern void noteIdleStretch (time_t length);
+extern void noteNotification (void);
+extern void noteLockPutOff (time_t now);
+extern void noteLockStarted (lockSource source);
+extern void noteLockEnded (void);
+extern void formatStats (char* text, size_t size);
+
+#endif /* __stats_h */
@@ -0,0 +1,85 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It declares
+ *          the stuff used for publishing how xautolock is doing in a
+ *          memory mapped file (see -statuspage).
+ *
+ *          The layout of that file is meant to be used by other
+ *          programs as well, so this file can be included on its own
+ *          (i.e. without including config.h first). Readers map the
+ *          file and take a consistent snapshot like this:
+ *
+ *            do
+ *            {
+ *              seq = page->sequence;
+ *              statusBarrier ();
+ *              copy = *page;
+ *              statusBarrier ();
+ *            } while ((seq & 1) || seq != page->sequence);
+ *
+ *          after having checked magic and version. The times are in
+ *          seconds according to time() if clock is STATUS_REALTIME,
+ *          or to clock_gettime (CLOCK_BOOTTIME) if it is
+ *          STATUS_BOOTTIME. Future versions will only ever add fields
+ *          at the end.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#ifndef __statuspage_h
+#define __statuspage_h
+
+#include <stdint.h>
+
+#define STATUS_MAGIC     0x78616c6bUL  /* "xalk"                       */
+#define STATUS_VERSION   1             /* as it says                   */
+#define STATUS_REALTIME  0             /* see above                    */
+#define STATUS_BOOTTIME  1             /* ditto                        */
+
+#ifdef __GNUC__
+#define statusBarrier()  __sync_synchronize ()
+#else /* __GNUC__ */
+#define statusBarrier()  /* let's hope volatile is good enough */
+#endif /* __GNUC__ */
+
+typedef struct
+{
+  uint32_t          magic;         /* STATUS_MAGIC                      */
+  uint32_t          version;       /* STATUS_VERSION                    */
+  volatile uint32_t sequence;      /* odd while being updated           */
+  int32_t           clock;         /* see above                         */
+  int64_t           pid;           /* of xautolock itself               */
+  int64_t           disabled;      /* as it says                        */
+  int64_t           lastActivity;  /* last user activity we know of     */
+  int64_t           lockTrigger;   /* when the locker is due            */
+  int64_t           killTrigger;   /* when the killer is due, or 0      */
+  int64_t           lockerPid;     /* of the running locker, or 0       */
+  int64_t           updated;       /* when any of the above changed     */
+} statusPage;
+
+/*
+ *  The rest is for xautolock itself.
+ */
+#ifdef __config_h
+typedef struct statusFile statusFile; /* see statuspage.c */
+
+extern void initStatusPage (Display* d);
+extern void closeStatusPage (void);
+extern void updateStatusPage (void);
+extern void saveStatusPage (statusFile** s);
+extern void loadStatusPage (statusFile* s);
+#endif /* __config_h */
+
+#endif /* __statuspage_h */
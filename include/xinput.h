@@ -0,0 +1,33 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It declares
+ *          the stuff used when the program is not using a screen saver
+ *          extension, but the X server supports version 2 of the X 
+ *          Input extension.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#ifndef __xinput_h
+#define __xinput_h
+
+#include "config.h"
+
+extern Bool initXInput (Display* d);
+extern Bool processRawEvents (Display* d);
+extern Bool initPointerEvents (Display* d);
+extern Bool processPointerEvent (XEvent* event);
+
+#endif /* __xinput_h */
@@ -0,0 +1,527 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It implements
+ *          the stuff used for controlling a running xautolock through
+ *          a Unix domain socket.
+ *
+ *          Messages sent through the X server (see message.c) don't
+ *          come with any kind of answer, so there is no way of telling
+ *          whether they arrived, let alone of asking xautolock how it's
+ *          doing. Hence the socket: clients send one command per line,
+ *          and get exactly one line back for each of them, as soon as
+ *          the command has been dealt with. The commands are named
+ *          after the corresponding command line options:
+ *
+ *            enable, disable, toggle, exit, locknow, unlocknow,
+ *            restart, reload
+ *                      -> "ok" or "ignored"
+ *            status    -> "disabled=0 lock=590 kill=none locker=0 idle=10
+ *                          latency=-1 locks=0 secured=-1/-1/-1"
+ *            stats     -> "idle=12/40/959/1432 locked=5123 locks=3/1/2
+ *                          today=1/0/1 notified=9 putoff=5"
+ *
+ *          (all on one line) where lock and kill are the number of
+ *          seconds until the locker and the killer are due, locker is
+ *          the process id of the running locker (if any), idle is the
+ *          number of seconds since the last user activity we know of,
+ *          latency is the number of microseconds it took to start the
+ *          most recent locker, locks is the number of times the screen
+ *          got secured, and secured gives the median, 99th percentile
+ *          and maximum number of microseconds that took (see engine.c).
+ *          For stats, see stats.c and the manual page.
+ *          Unknown values are -1. Unknown commands get "error". Clients
+ *          may keep the connection open for as many commands as they
+ *          like.
+ *
+ *          The socket lives in $XDG_RUNTIME_DIR (or in a directory of
+ *          our own in /tmp), and is only accessible to its owner. Both
+ *          ends also check who is on the other side, where the kernel
+ *          can tell.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#ifdef __linux__
+#define _GNU_SOURCE  /* for struct ucred */
+#endif /* __linux__ */
+
+#include "control.h"
+#include "idlealarm.h"
+#include "message.h"
+#include "options.h"
+#include "state.h"
+#include "stats.h"
+#include "miscutil.h"
+
+/*
+ *  Work out where the files for this display live. The screen
+ *  number is irrelevant, and the display name may contain slashes
+ *  (e.g. on MacOS X). Returns whether there is a safe place for 
+ *  them, and the name fits.
+ *
+ *  Anyone can create files in /tmp, including ones with the names
+ *  we are about to use. So unless $XDG_RUNTIME_DIR says otherwise,
+ *  the files go into a directory of our own in there, which had 
+ *  better be accessible to nobody else. If someone beat us to it,
+ *  we do without.
+ */
+Bool
+runtimePath (Display* d, const char* suffix, char* path, size_t size)
+{
+  const char* dir;           /* as it says                */
+  char        tmpDir[64];    /* private directory in /tmp */
+  struct stat info;          /* as it says                */
+  char*       name;          /* display name, cleaned up  */
+  char*       ptr;           /* iterator                  */
+  int         length;        /* as it says                */
+
+  if (!(dir = getenv ("XDG_RUNTIME_DIR")) || !*dir)
+  {
+    length = snprintf (tmpDir, sizeof (tmpDir), "/tmp/%s-%d",
+                       progName, (int) getuid ());
+
+    if (   length <= 0 || length >= (int) sizeof (tmpDir)
+        || (mkdir (tmpDir, 0700) && errno != EEXIST)
+        || lstat (tmpDir, &info)
+        || !S_ISDIR (info.st_mode)
+        || info.st_uid != getuid ()
+        || (info.st_mode & 077))
+    {
+      return False;
+    }
+
+    dir = tmpDir;
+  }
+
+  name = newArray (char, strlen (DisplayString (d)) + 1);
+  (void) strcpy (name, DisplayString (d));
+
+  if (   (ptr = strrchr (name, ':'))  /* = intended */
+      && (ptr = strchr (ptr, '.')))   /* = intended */
+  {
+    *ptr = '\0';
+  }
+
+  for (ptr = name; *ptr; ++ptr) if (*ptr == '/') *ptr = '_';
+
+  length = snprintf (path, size, "%s/%s-%d-%s%s", 
+                     dir, progName, (int) getuid (), name, suffix);
+  free (name);
+
+  return length > 0 && length < (int) size;
+}
+
+#ifdef HasPoll
+
+#define MAX_CLIENTS  (MAX_CONTROL_FDS - 1)
+#define LINE_SIZE    64
+#define REPLY_SIZE   (LINE_SIZE * 6)
+
+typedef struct
+{
+  int          fd;               /* -1 if not in use     */
+  unsigned     length;           /* bytes in the buffer  */
+  char         line[LINE_SIZE];  /* partial command line */
+} aClient;
+
+static struct
+{
+  int                fd;                   /* listening socket */
+  struct sockaddr_un address;              /* as it says       */
+  aClient            clients[MAX_CLIENTS]; /* as it says       */
+} control = { -1 };
+
+static const struct
+{
+  const char*  name;        /* as it says           */
+  message      msg;         /* as it says           */
+} commands[] =
+{
+  {"disable"   , msg_disable  },
+  {"enable"    , msg_enable   },
+  {"toggle"    , msg_toggle   },
+  {"exit"      , msg_exit     },
+  {"locknow"   , msg_lockNow  },
+  {"unlocknow" , msg_unlockNow},
+  {"restart"   , msg_restart  },
+  {"reload"    , msg_reload   },
+  {"status"    , msg_status   },
+  {"stats"     , msg_stats    },
+};
+
+#define nofCommands (sizeof (commands) / sizeof (commands[0]))
+
+static Bool
+getAddress (Display* d, struct sockaddr_un* address)
+{
+  (void) memset (address, 0, sizeof (*address));
+  address->sun_family = AF_UNIX;
+
+  return runtimePath (d, "", address->sun_path, sizeof (address->sun_path));
+}
+
+static void
+removeSocket (void)
+{
+  if (control.fd >= 0) (void) unlink (control.address.sun_path);
+}
+
+/*
+ *  Function for finding out whether whoever is on the other side of
+ *  a connection runs as the same user as we do. Where the kernel
+ *  can't tell, we have to trust the permissions of the socket.
+ */
+static Bool
+peerIsUs (int fd)
+{
+#ifdef SO_PEERCRED
+  struct ucred peer;                   /* as it says */
+  socklen_t    length = sizeof (peer); /* as it says */
+
+  return    !getsockopt (fd, SOL_SOCKET, SO_PEERCRED, &peer, &length)
+         && peer.uid == getuid ();
+#else /* SO_PEERCRED */
+  return True;
+#endif /* SO_PEERCRED */
+}
+
+/*
+ *  Function for creating the control socket. Failing to do so isn't
+ *  fatal: the X server based messages still work.
+ */
+void
+initControl (Display* d)
+{
+  mode_t mask; /* as it says   */
+  int    i;    /* loop counter */
+
+  for (i = 0; i < MAX_CLIENTS; ++i) control.clients[i].fd = -1;
+
+  if (!getAddress (d, &control.address))
+  {
+    error0 ("No safe place for the control socket, not using it.\n");
+    return;
+  }
+
+  if ((control.fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0) /* = intended */
+  {
+    error0 ("Couldn't create the control socket.\n");
+    return;
+  }
+
+ /*
+  *  Since we've checked that we are the only xautolock around, any
+  *  socket already there is a leftover. The umask makes sure that
+  *  nobody else can connect to the socket.
+  */
+  (void) unlink (control.address.sun_path);
+  mask = umask (077);
+
+  if (   bind (control.fd, (struct sockaddr*) &control.address,
+               sizeof (control.address))
+      || listen (control.fd, MAX_CLIENTS))
+  {
+    error1 ("Couldn't bind the control socket to %s.\n",
+            control.address.sun_path);
+    (void) close (control.fd);
+    control.fd = -1;
+  }
+  else
+  {
+    (void) fcntl (control.fd, F_SETFD, FD_CLOEXEC);
+    (void) fcntl (control.fd, F_SETFL, O_NONBLOCK);
+    (void) atexit (removeSocket);
+  }
+
+  (void) umask (mask);
+}
+
+/*
+ *  Function for telling the main loop what to wait for.
+ */
+int
+addControlFds (struct pollfd* fds)
+{
+  int nofFds = 0; /* as it says   */
+  int i;          /* loop counter */
+
+  if (control.fd < 0) return 0;
+
+  fds[nofFds].fd = control.fd;
+  fds[nofFds++].events = POLLIN;
+
+  for (i = 0; i < MAX_CLIENTS; ++i)
+  {
+    if (control.clients[i].fd >= 0)
+    {
+      fds[nofFds].fd = control.clients[i].fd;
+      fds[nofFds++].events = POLLIN;
+    }
+  }
+
+  return nofFds;
+}
+
+static void
+dropClient (aClient* client)
+{
+  (void) close (client->fd);
+  client->fd = -1;
+}
+
+/*
+ *  Replies are short enough to always fit in the socket buffer,
+ *  so there is no need to queue them. Clients that went away 
+ *  shouldn't get us killed by SIGPIPE.
+ */
+static void
+reply (aClient* client, const char* text)
+{
+  size_t length = strlen (text);
+
+  if (send (client->fd, text, length, MSG_NOSIGNAL) != (ssize_t) length)
+  {
+    dropClient (client);
+  }
+}
+
+static void
+executeCommand (Display* d, aClient* client, const char* line)
+{
+  char     text[REPLY_SIZE];     /* as it says   */
+  char     killText[24];         /* as it says   */
+  time_t   now = currentTime (); /* as it says   */
+  unsigned i;                    /* loop counter */
+
+  for (i = 0; i < nofCommands; ++i)
+  {
+    if (!strcmp (line, commands[i].name)) break;
+  }
+
+  if (i == nofCommands)
+  {
+    reply (client, "error\n");
+  }
+  else if (commands[i].msg == msg_status)
+  {
+    refreshIdleTime (d);
+    now = currentTime ();
+
+    if (killTrigger)
+    {
+      (void) sprintf (killText, "%ld", (long) (killTrigger - now));
+    }
+    else
+    {
+      (void) strcpy (killText, "none");
+    }
+
+    (void) sprintf (text, 
+                    "disabled=%d lock=%ld kill=%s locker=%ld idle=%ld"
+                    " latency=%ld locks=%lu secured=%ld/%ld/%ld\n",
+                    disabled ? 1 : 0, (long) (lockTrigger - now), killText,
+                    (long) lockerPid, (long) (now - lastActivity),
+                    lockLatency, lockHistogram->total,
+                    histogramPercentile (lockHistogram, 50),
+                    histogramPercentile (lockHistogram, 99),
+                    lockHistogram->total ? lockHistogram->max : -1L);
+    reply (client, text);
+  }
+  else if (commands[i].msg == msg_stats)
+  {
+    formatStats (text, sizeof (text));
+    reply (client, text);
+  }
+  else if (commands[i].msg == msg_exit || commands[i].msg == msg_restart)
+  {
+   /*
+    *  These don't return if they succeed, so answer first.
+    */
+    if (secure)
+    {
+      reply (client, "ignored\n");
+    }
+    else
+    {
+      reply (client, "ok\n");
+      (void) actOnMessage (d, commands[i].msg);
+    }
+  }
+  else
+  {
+    reply (client, actOnMessage (d, commands[i].msg) ? "ok\n"
+                                                     : "ignored\n");
+  }
+}
+
+/*
+ *  Function for dealing with whatever arrived on the control socket.
+ *  Never blocks.
+ */
+void
+processControl (Display* d)
+{
+  int      fd;     /* new connection      */
+  aClient* client; /* as it says          */
+  ssize_t  got;    /* bytes read          */
+  char*    eol;    /* end of command line */
+  int      i;      /* loop counter        */
+
+  if (control.fd < 0) return;
+
+  while ((fd = accept (control.fd, 0, 0)) >= 0) /* = intended */
+  {
+    for (i = 0; i < MAX_CLIENTS && control.clients[i].fd >= 0; ++i)
+    {
+      /* find a free slot */
+    }
+
+    if (i == MAX_CLIENTS || !peerIsUs (fd))
+    {
+      (void) close (fd);
+      continue;
+    }
+
+    (void) fcntl (fd, F_SETFD, FD_CLOEXEC);
+    (void) fcntl (fd, F_SETFL, O_NONBLOCK);
+    control.clients[i].fd = fd;
+    control.clients[i].length = 0;
+  }
+
+  for (i = 0; i < MAX_CLIENTS; ++i)
+  {
+    client = &control.clients[i];
+
+    while (client->fd >= 0)
+    {
+      got = read (client->fd, client->line + client->length,
+                  LINE_SIZE - 1 - client->length);
+
+      if (got < 0 && (errno == EAGAIN || errno == EINTR)) break;
+
+      if (got <= 0)
+      {
+        dropClient (client);
+        break;
+      }
+
+      client->length += (unsigned) got;
+      client->line[client->length] = '\0';
+
+      while (   client->fd >= 0
+             && (eol = strchr (client->line, '\n'))) /* = intended */
+      {
+        *eol = '\0';
+        if (eol > client->line && eol[-1] == '\r') eol[-1] = '\0';
+        executeCommand (d, client, client->line);
+        client->length -= (unsigned) (eol + 1 - client->line);
+        (void) memmove (client->line, eol + 1, client->length + 1);
+      }
+
+     /*
+      *  Nobody needs commands this long.
+      */
+      if (client->fd >= 0 && client->length == LINE_SIZE - 1)
+      {
+        reply (client, "error\n");
+        if (client->fd >= 0) dropClient (client);
+      }
+    }
+  }
+}
+
+/*
+ *  Function for sending a message to a running xautolock through its
+ *  control socket. Returns False if there is no such socket, in which
+ *  case the caller should fall back to the X server. Otherwise it
+ *  reports the outcome and exits.
+ */
+Bool
+sendControlMessage (Display* d)
+{
+  struct sockaddr_un address;               /* as it says    */
+  char               answer[REPLY_SIZE];    /* as it says    */
+  size_t             length = 0;            /* of the answer */
+  ssize_t            got;                   /* as it says    */
+  int                fd;                    /* as it says    */
+  unsigned           i;                     /* loop counter  */
+
+  for (i = 0; i < nofCommands && commands[i].msg != messageToSend; ++i)
+  {
+    /* find the command */
+  }
+
+  if (   i == nofCommands
+      || !getAddress (d, &address)
+      || (fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0) /* = intended */
+  {
+    return False;
+  }
+
+  if (   connect (fd, (struct sockaddr*) &address, sizeof (address))
+      || !peerIsUs (fd))
+  {
+    (void) close (fd);
+    return False;
+  }
+
+  (void) sprintf (answer, "%s\n", commands[i].name);
+
+  if (   send (fd, answer, strlen (answer), MSG_NOSIGNAL)
+      != (ssize_t) strlen (answer))
+  {
+    (void) close (fd);
+    return False;
+  }
+
+  while (   length < sizeof (answer) - 1
+         && (got = read (fd, answer + length, 1)) == 1) /* = intended */
+  {
+    if (answer[length++] == '\n') break;
+  }
+
+  answer[length] = '\0';
+  (void) close (fd);
+
+  if (!strncmp (answer, "ok\n", 3))
+  {
+    exit (EXIT_SUCCESS);
+  }
+  else if (   (messageToSend == msg_status || messageToSend == msg_stats)
+           && strchr (answer, '='))
+  {
+    (void) fputs (answer, stdout);
+    exit (EXIT_SUCCESS);
+  }
+  else if (!strncmp (answer, "ignored\n", 8))
+  {
+    error1 ("The running %s ignored the request.\n", progName);
+  }
+  else
+  {
+    error1 ("The running %s didn't understand the request.\n", progName);
+  }
+
+  exit (EXIT_FAILURE);
+  /*NOTREACHED*/
+}
+
+#else /* HasPoll */
+
+void initControl (Display* d) {}
+void processControl (Display* d) {}
+Bool sendControlMessage (Display* d) { return False; }
+
+#endif /* HasPoll */
@@ -14,6 +14,9 @@
  *          is needed in order to interfere as little as possible with
  *          the event propagation mechanism. Whenever a new window is 
  *          created by an application, a similar process takes place. 
+ *          We keep track of which windows we've already dealt with,
+ *          so that no window gets processed twice, and so that windows
+ *          which die young don't get processed at all.
  *
  *          Please send bug reports etc. to mce@scarlet.be.
  * 
@@ -29,68 +32,456 @@
  *****************************************************************************/
 
 #include "diy.h"
+#include "engine.h"
 #include "state.h"
 #include "options.h"
+#include "message.h"
+#include "probes.h"
 #include "miscutil.h"
 
 static void selectEvents (Window window, Bool substructureOnly);
 
 /*
- *  Window queue management.
+ *  Bookkeeping of the windows we know about. This is a simple open 
+ *  addressing hash table, which grows whenever it gets half full. A
+ *  window is in here from the moment it is queued until it dies.
  */
-typedef struct item
+#define WS_NONE         0     /* unknown window                   */
+#define WS_PENDING      1     /* still waiting in the queue       */
+#define WS_REGISTERED   2     /* all events have been selected    */
+
+#define TABLE_SIZE      1024  /* initial number of slots          */
+
+#ifdef HasXcb
+#define REQUESTS_PER_WINDOW 3 /* see the XCB version of selectEvents () */
+#else /* HasXcb */
+#define REQUESTS_PER_WINDOW 4 /* see the Xlib version of selectEvents () */
+#endif /* HasXcb */
+
+typedef struct
+{
+  Window       window;
+  int          state;
+} aWindow;
+
+static struct
+{
+  aWindow*     slots;     /* the hash table            */
+  unsigned     size;      /* number of slots, a power
+                             of two                    */
+  unsigned     used;      /* number of slots in use    */
+} windows;
+
+static diyStats stats;    /* as it says                */
+
+static void noteMemory (void);
+
+static unsigned
+hashWindow (Window window)
+{
+  return (unsigned) ((window ^ (window >> 16)) * 2654435761UL) 
+         & (windows.size - 1);
+}
+
+static aWindow*
+findWindow (Window window)
+{
+  unsigned i;
+
+  for (i = hashWindow (window); windows.slots[i].window; )
+  {
+    if (windows.slots[i].window == window) return &windows.slots[i];
+    i = (i + 1) & (windows.size - 1);
+  }
+
+  return &windows.slots[i];
+}
+
+static void setWindowState (Window window, int state);
+
+static void
+growTable (void)
+{
+  aWindow* old = windows.slots;
+  unsigned oldSize = windows.size;
+  unsigned i;
+
+  windows.size = oldSize ? 2 * oldSize : TABLE_SIZE;
+  windows.slots = newArray (aWindow, windows.size);
+  windows.used = 0;
+  (void) memset (windows.slots, 0, sizeof (aWindow) * windows.size);
+
+  for (i = 0; i < oldSize; ++i)
+  {
+    if (old[i].window) setWindowState (old[i].window, old[i].state);
+  }
+
+  if (old) free (old);
+  noteMemory ();
+}
+
+static int
+windowState (Window window)
+{
+  return findWindow (window)->state;
+}
+
+static void
+setWindowState (Window window, int state)
+{
+  aWindow* slot;
+
+  if (2 * (windows.used + 1) > windows.size) growTable ();
+
+  slot = findWindow (window);
+
+  if (!slot->window)
+  {
+    slot->window = window;
+    ++windows.used;
+  }
+
+  slot->state = state;
+}
+
+static void
+forgetWindow (Window window)
+{
+  unsigned i;     /* the slot being emptied */
+  unsigned j;     /* the slot being checked */
+  unsigned home;  /* where j would like to be */
+  aWindow* slot;
+
+  slot = findWindow (window);
+  if (!slot->window) return;
+
+ /*
+  *  Move any later entries of the same probe sequence back, so that
+  *  lookups never run into a hole.
+  */
+  i = (unsigned) (slot - windows.slots);
+
+  for (j = (i + 1) & (windows.size - 1); 
+       windows.slots[j].window; 
+       j = (j + 1) & (windows.size - 1))
+  {
+    home = hashWindow (windows.slots[j].window);
+
+    if (((j - home) & (windows.size - 1)) >= ((j - i) & (windows.size - 1)))
+    {
+      windows.slots[i] = windows.slots[j];
+      i = j;
+    }
+  }
+
+  windows.slots[i].window = None;
+  windows.slots[i].state = WS_NONE;
+  --windows.used;
+}
+
+/*
+ *  Window queue management. Since windows are added in order of
+ *  creation time, the queue is a simple ring buffer. It starts out
+ *  large enough for a few windows per second during CREATION_DELAY
+ *  seconds, and only grows if a burst of new windows overflows it.
+ *  That way, window storms don't cause any allocator churn.
+ */
+#define QUEUE_SIZE      (8 * CREATION_DELAY)
+
+typedef struct
 {
   Window       window;
   time_t       creationtime;
-  struct item* next;
-} anItem, *item;
+} anItem;
 
 static struct 
 {
   Display*     display;
-  struct item* head;
-  struct item* tail;
+  anItem*      items;     /* the ring buffer           */
+  unsigned     size;      /* number of slots           */
+  unsigned     head;      /* index of the oldest entry */
+  unsigned     depth;     /* number of entries         */
+  unsigned     peak;      /* maximum depth so far      */
+  time_t       now;       /* time of the current batch */
 } queue;
 
+/*
+ *  Keep track of how much memory the bookkeeping takes.
+ */
+static void
+noteMemory (void)
+{
+  size_t bytes =   queue.size * sizeof (anItem) 
+                 + windows.size * sizeof (aWindow);
+
+  if (bytes > stats.peakBytes) stats.peakBytes = bytes;
+}
+
+static void
+growQueue (void)
+{
+  anItem*  items = newArray (anItem, 2 * queue.size);
+  unsigned i;
+
+  for (i = 0; i < queue.depth; ++i)
+  {
+    items[i] = queue.items[(queue.head + i) % queue.size];
+  }
+
+  free (queue.items);
+  queue.items = items;
+  queue.size *= 2;
+  queue.head = 0;
+  noteMemory ();
+}
+
 static void
 addToQueue (Window window)
 {
-  item newItem = newObj (anItem);
+  anItem* newItem;
 
-  newItem->window = window;
-  newItem->creationtime = time (0);
-  newItem->next = 0;
+ /*
+  *  A window that we've already been through as part of one of its
+  *  ancestors needs no further attention. Queueing it anyway would 
+  *  mark it as pending again, and have it go through selectEvents()
+  *  for a second time.
+  */
+  if (windowState (window) == WS_REGISTERED)
+  {
+    stats.avoidedRequests += REQUESTS_PER_WINDOW;
+    return;
+  }
 
-  if (!queue.head) queue.head = newItem;
-  if ( queue.tail) queue.tail->next = newItem;
+  if (queue.depth == queue.size) growQueue ();
 
-  queue.tail = newItem;
+  probe2 (add_to_queue, (long) window, queue.depth);
+  newItem = &queue.items[(queue.head + queue.depth) % queue.size];
+  newItem->window = window;
+  newItem->creationtime = queue.now;
+  setWindowState (window, WS_PENDING);
+
+  if (++queue.depth > queue.peak) queue.peak = queue.depth;
 }
 
 static void
 processQueue (time_t age)
 {
-  if (queue.head)
+  anItem* current;
+
+  while (queue.depth)
   {
-    time_t now = time (0);
-    item current = queue.head;
+    current = &queue.items[queue.head];
+
+    if (current->creationtime + age >= queue.now) break;
 
-    while (current && current->creationtime + age < now)
+    queue.head = (queue.head + 1) % queue.size;
+    --queue.depth;
+
+   /*
+    *  The window may have died in the mean time, or may have been
+    *  dealt with as part of one of its ancestors.
+    */
+    if (windowState (current->window) == WS_PENDING)
     {
       selectEvents (current->window, False);
-      queue.head = current->next;
-      free (current);
-      current = queue.head;
     }
+    else
+    {
+      stats.avoidedRequests += REQUESTS_PER_WINDOW;
+    }
+  }
+}
 
-    if (!queue.head) queue.tail = 0;
+static Bool
+isRootWindow (Window window)
+{
+  int s;
+
+  for (s = -1; ++s < ScreenCount (queue.display); )
+  {
+    if (window == RootWindowOfScreen (ScreenOfDisplay (queue.display, s)))
+    {
+      return True;
+    }
   }
+
+  return False;
 }
 
 /*
  *  Function for selecting all interesting events on a given 
- *  (tree of) window(s).
+ *  (tree of) window(s). Root windows keep LEGACY_MESSAGE_MASK,
+ *  which message.c relies on.
  */
+#ifdef HasXcb
+
+static void 
+selectEvents (Window window, Bool substructureOnly)
+{
+  xcb_connection_t*                   c;            /* as it says     */
+  xcb_window_t*                       level;        /* current level  */
+  xcb_window_t*                       next;         /* next level     */
+  unsigned                            nofWindows;   /* in this level  */
+  unsigned                            nofNext;      /* in next level  */
+  unsigned                            i, j;         /* loop counters  */
+  uint32_t                            mask;         /* event mask     */
+  Bool*                               alive;        /* still there?   */
+  xcb_get_window_attributes_cookie_t* attrCookies;  /* as it says     */
+  xcb_query_tree_cookie_t*            treeCookies;  /* as it says     */
+  xcb_get_window_attributes_reply_t*  attribs;      /* as it says     */
+  xcb_query_tree_reply_t**            trees;        /* as it says     */
+  xcb_window_t*                       children;     /* as it says     */
+  xcb_generic_error_t*                error;        /* as it says     */
+  Bool                                askedAttribs; /* as it says     */
+
+  probe2 (select_events, (long) window, substructureOnly);
+
+ /*
+  *  This does exactly the same thing as the plain Xlib version below,
+  *  except that it walks the tree one level at a time. All requests
+  *  for a level are sent out before waiting for any of the replies,
+  *  so that it takes two round trips per level of the window tree, 
+  *  instead of three per window. This makes quite a difference when
+  *  the server is far away. 
+  */
+  c = XGetXCBConnection (queue.display);
+  level = newArray (xcb_window_t, 1);
+  level[0] = (xcb_window_t) window;
+  nofWindows = 1;
+
+  while (nofWindows)
+  {
+    if (!substructureOnly)
+    {
+     /*
+      *  Leave out the subtrees we've already been through.
+      */
+      for (i = j = 0; i < nofWindows; ++i)
+      {
+        if (windowState (level[i]) == WS_REGISTERED)
+        {
+          stats.avoidedRequests += REQUESTS_PER_WINDOW;
+        }
+        else
+        {
+          level[j++] = level[i];
+        }
+      }
+
+      if (!(nofWindows = j)) break; /* = intended */
+    }
+
+    alive = newArray (Bool, nofWindows);
+    attrCookies = newArray (xcb_get_window_attributes_cookie_t, nofWindows);
+    treeCookies = newArray (xcb_query_tree_cookie_t, nofWindows);
+    trees = newArray (xcb_query_tree_reply_t*, nofWindows);
+
+    askedAttribs = False;
+
+    if (!substructureOnly)
+    {
+      for (i = 0; i < nofWindows; ++i)
+      {
+        if (!isRootWindow (level[i]))
+        {
+          attrCookies[i] = xcb_get_window_attributes (c, level[i]);
+          askedAttribs = True;
+          ++stats.requests;
+        }
+      }
+    }
+
+   /*
+    *  Build the appropriate event masks, following the same rules as
+    *  the Xlib version. Windows which have disappeared in the mean 
+    *  time are silently dropped.
+    */
+    for (i = 0; i < nofWindows; ++i)
+    {
+      mask = SubstructureNotifyMask;
+      alive[i] = True;
+
+      if (isRootWindow (level[i])) mask |= LEGACY_MESSAGE_MASK;
+
+      if (substructureOnly)
+      {
+        /* nothing to add */
+      }
+      else if (isRootWindow (level[i]))
+      {
+        mask |= KeyPressMask;
+      }
+      else if ((attribs = xcb_get_window_attributes_reply
+                            (c, attrCookies[i], &error))) /* = intended */
+      {
+        mask |=   (attribs->all_event_masks | attribs->do_not_propagate_mask)
+                & KeyPressMask;
+        free (attribs);
+      }
+      else
+      {
+        free (error);
+        alive[i] = False;
+        continue;
+      }
+
+      (void) xcb_change_window_attributes (c, level[i], XCB_CW_EVENT_MASK,
+                                           &mask);
+      treeCookies[i] = xcb_query_tree (c, level[i]);
+      stats.requests += 2;
+
+      if (!substructureOnly) setWindowState (level[i], WS_REGISTERED);
+    }
+
+   /*
+    *  Now collect the children, which make up the next level.
+    */
+    for (nofNext = i = 0; i < nofWindows; ++i)
+    {
+      trees[i] = 0;
+
+      if (!alive[i]) continue;
+
+      if ((trees[i] = xcb_query_tree_reply (c, treeCookies[i], &error)))
+      {
+        nofNext += xcb_query_tree_children_length (trees[i]);
+      }
+      else
+      {
+        free (error);
+      }
+    }
+
+    stats.roundTrips += askedAttribs ? 2 : 1;
+    next = newArray (xcb_window_t, MAX (nofNext, 1));
+
+    for (nofNext = i = 0; i < nofWindows; ++i)
+    {
+      if (!trees[i]) continue;
+
+      children = xcb_query_tree_children (trees[i]);
+
+      for (j = 0; j < xcb_query_tree_children_length (trees[i]); ++j)
+      {
+        next[nofNext++] = children[j];
+      }
+
+      free (trees[i]);
+    }
+
+    free (alive);
+    free (attrCookies);
+    free (treeCookies);
+    free (trees);
+    free (level);
+
+    level = next;
+    nofWindows = nofNext;
+  }
+
+  free (level);
+}
+#else /* HasXcb */
 static void 
 selectEvents (Window window, Bool substructureOnly)
 {
@@ -101,9 +492,19 @@ selectEvents (Window window, Bool substructureOnly)
   unsigned          i;                 /* loop counter              */
   XWindowAttributes attribs;           /* attributes of the window  */
 
+  probe2 (select_events, (long) window, substructureOnly);
+
+  if (!substructureOnly && windowState (window) == WS_REGISTERED)
+  {
+    stats.avoidedRequests += REQUESTS_PER_WINDOW;
+    return;
+  }
+
  /*
   *  Start by querying the server about the root and parent windows.
   */
+  ++stats.roundTrips;
+  ++stats.requests;
   if (!XQueryTree (queue.display, window, &root, &parent,
                    &children, &nofChildren))
   {
@@ -123,9 +524,13 @@ selectEvents (Window window, Bool substructureOnly)
   *  also asked for them, or if they are not being propagated up the
   *  window tree.
   */
+  ++stats.requests;
+
   if (substructureOnly)
   {
-    (void) XSelectInput (queue.display, window, SubstructureNotifyMask);
+    (void) XSelectInput (queue.display, window, 
+                           SubstructureNotifyMask
+                         | (isRootWindow (window) ? LEGACY_MESSAGE_MASK : 0));
   }
   else
   {
@@ -134,29 +539,36 @@ selectEvents (Window window, Bool substructureOnly)
       attribs.all_event_masks = 
       attribs.do_not_propagate_mask = KeyPressMask;
     }
-    else if (!XGetWindowAttributes (queue.display, window, &attribs))
+    else
     {
-      return;
+      ++stats.roundTrips;
+      ++stats.requests;
+      if (!XGetWindowAttributes (queue.display, window, &attribs)) return;
     }
 
     (void) XSelectInput (queue.display, window, 
                            SubstructureNotifyMask
+                         | (parent == None ? LEGACY_MESSAGE_MASK : 0)
                          | (  (  attribs.all_event_masks
                                | attribs.do_not_propagate_mask)
                             & KeyPressMask));
+    setWindowState (window, WS_REGISTERED);
   }
 
  /*
   *  Now ask for the list of children again, since it might have changed
   *  in between the last time and us selecting SubstructureNotifyMask.
   *
-  *  There is a (very small) chance that we might process a subtree twice:
-  *  child windows that have been created after our XSelectinput() has
-  *  been processed but before we get to the XQueryTree() bit will be 
-  *  in this situation. This is harmless. It could be avoided by using
-  *  XGrabServer(), but that'd be an impolite thing to do, and since it
-  *  isn't required...
+  *  Child windows that have been created after our XSelectinput() has
+  *  been processed but before we get to the XQueryTree() bit will both
+  *  show up here and as a CreateNotify event. This is harmless, since 
+  *  by the time that event gets processed, they will be known as 
+  *  registered, so addToQueue() leaves them alone. It could be avoided
+  *  by using XGrabServer(), but that'd be an impolite thing to do, and
+  *  since it isn't required...
   */
+  ++stats.roundTrips;
+  ++stats.requests;
   if (!XQueryTree (queue.display, window, &root, &parent,
                    &children, &nofChildren))
   {
@@ -173,6 +585,7 @@ selectEvents (Window window, Bool substructureOnly)
 
   if (nofChildren) (void) XFree ((char*) children);
 }
+#endif /* HasXcb */
 
 /*
  *  Function for processing any events that have come in since 
@@ -182,6 +595,11 @@ selectEvents (Window window, Bool substructureOnly)
 void
 processEvents (void)
 {
+ /*
+  *  One look at the clock is plenty for the whole lot. 
+  */
+  queue.now = currentTime ();
+
   while (XPending (queue.display))
   {
     XEvent event;
@@ -192,6 +610,10 @@ processEvents (void)
       {
         addToQueue (event.xcreatewindow.window);
       }
+      else if (event.type == DestroyNotify)
+      {
+        forgetWindow (event.xdestroywindow.window);
+      }
     }
     else
     {
@@ -205,8 +627,13 @@ processEvents (void)
     if (   event.type == KeyPress
         && !event.xany.send_event)
     {
+      noteActivity ();
       resetTriggers ();
     }
+    else
+    {
+      handleEvent (queue.display, &event);
+    }
   }
 
  /*
@@ -225,8 +652,13 @@ initDiy (Display* d)
   int s;
 
   queue.display = d;
-  queue.tail = 0;
+  queue.items = newArray (anItem, QUEUE_SIZE);
+  queue.size = QUEUE_SIZE;
   queue.head = 0; 
+  queue.depth = 0;
+  queue.peak = 0;
+  queue.now = currentTime ();
+  noteMemory ();
 
   for (s = -1; ++s < ScreenCount (d); )
   {
@@ -235,3 +667,15 @@ initDiy (Display* d)
     selectEvents (root, True);
   }
 }
+
+/*
+ *  Function for reporting how busy we are (and have been).
+ */
+void
+getDiyStats (diyStats* result)
+{
+  *result = stats;
+  result->queueDepth = queue.depth;
+  result->queuePeak = queue.peak;
+  result->windows = windows.used;
+}
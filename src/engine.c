@@ -19,10 +19,238 @@
  *****************************************************************************/
 
 #include "engine.h"
+#include "message.h"
 #include "options.h"
 #include "state.h"
+#include "xinput.h"
+#include "monitors.h"
+#include "journal.h"
+#include "stats.h"
+#include "metrics.h"
+#include "session.h"
 #include "miscutil.h"
 
+/*
+ *  Function for writing down and counting an idle stretch that has
+ *  just come to an end. Mere pauses between key strokes don't count.
+ */
+static void
+endIdleStretch (time_t length)
+{
+  if (length >= JOURNAL_IDLE)
+  {
+    journal (jr_activity, (long) length);
+    noteIdleStretch (length);
+  }
+}
+
+/*
+ *  Function for acting on the idle time reported by the server,
+ *  whichever way we happened to learn about it. `watched' tells
+ *  whether any input since the previous report would have been
+ *  reported right away.
+ *
+ *  Idle stretches are measured from what the server reports, not
+ *  from when we happen to hear from it: in tickless mode, the user
+ *  may have been busy for quite a while by then. A stretch ends when
+ *  the server says the user is back, or when it reports a stretch
+ *  that started later. If we weren't watching in the mean time, all
+ *  we know is how long it had lasted when we last looked.
+ */
+static time_t prevQuery = 0; /* time of the previous call          */
+static time_t idleFrom = 0;  /* start of the current stretch, or 0 */
+static time_t idleSeen = 0;  /* when we last saw it going on       */
+
+void
+processIdleTime (Time idleTime, Bool watched)
+{
+  time_t        now;           /* as it says                   */
+  time_t        lastInput;     /* time of the last input event */
+
+  now = currentTime ();
+  lastActivity = now - (time_t) (idleTime / 1000);
+
+  if (idleFrom && lastActivity > idleFrom + 1)
+  {
+    endIdleStretch (watched ? lastActivity - idleFrom : idleSeen - idleFrom);
+    idleFrom = 0;
+  }
+
+  if (idleTime >= 1000)
+  {
+    if (!idleFrom) idleFrom = lastActivity;
+    idleSeen = now;
+  }
+
+  if (idleTime < 1000)  
+  {
+    resetTriggers ();
+  }
+  else if (tickless && prevQuery)
+  {
+   /*
+    *  In tickless mode we may well have slept right through some
+    *  user activity. If so, move the triggers to where they would
+    *  have been had we been looking at the time.
+    */
+    lastInput = now - (time_t) (idleTime / 1000);
+
+    if (lastInput > prevQuery)
+    {
+      setLockTrigger (lockTime - (now - lastInput));
+      if (killTrigger) setKillTrigger (killTime - (now - lastInput));
+    }
+  }
+
+  prevQuery = now;
+}
+
+/*
+ *  Lock latency bookkeeping. We consider the screen to be secured as
+ *  soon as a top level window gets mapped after we decided to lock,
+ *  that being the locker's window in all but the most unlucky of
+ *  cases. This is an approximation: the window may belong to any
+ *  client, and there is no reliable way to tell whether it is the
+ *  locker's (lockers tend to use override redirect windows, which
+ *  carry no _NET_WM_PID or the like). The man page says as much.
+ *
+ *  To find out, we temporarily add SubstructureNotifyMask to
+ *  whatever we are already selecting on the root windows. This has
+ *  to be done before starting the locker, which may well be faster
+ *  than us.
+ */
+static double lockDecided = 0.0;     /* when we decided to lock          */
+static long*  rootMasks = 0;         /* what we selected before, per root */
+static Bool   watchingRoots = False; /* whether the above is in effect   */
+
+static void
+watchRoots (Display* d)
+{
+  XWindowAttributes attrs; /* as it says     */
+  int               s;     /* screen counter */
+
+  if (watchingRoots) return;
+
+  if (!rootMasks) rootMasks = newArray (long, ScreenCount (d));
+
+  for (s = 0; s < ScreenCount (d); ++s)
+  {
+    rootMasks[s] = XGetWindowAttributes (d, RootWindow (d, s), &attrs)
+                 ? attrs.your_event_mask : NoEventMask;
+    (void) XSelectInput (d, RootWindow (d, s), 
+                         rootMasks[s] | SubstructureNotifyMask);
+    countRoundTrip (xs_engine);
+    countRequests (xs_engine, 1);
+  }
+
+  watchingRoots = True;
+}
+
+static void
+unwatchRoots (Display* d)
+{
+  int s; /* screen counter */
+
+  if (!watchingRoots) return;
+
+  for (s = 0; s < ScreenCount (d); ++s)
+  {
+    (void) XSelectInput (d, RootWindow (d, s), rootMasks[s]);
+    countRequests (xs_engine, 1);
+  }
+
+  watchingRoots = False;
+}
+
+static void
+reportLatencies (const char* name, const histogram* h)
+{
+  if (!h->total) return;
+
+  (void) fprintf (stderr, "%s: %s%s%lu locks, secured after %ld us (p50), "
+                          "%ld us (p99), %ld us (max)\n",
+                  progName, name ? name : "", name ? ": " : "", h->total, 
+                  histogramPercentile (h, 50),
+                  histogramPercentile (h, 99),
+                  h->max);
+}
+
+static void
+reportLockLatency (void)
+{
+  if (!noCloseErr) return; /* nobody to tell */
+
+#ifdef HasPoll
+  if (displayList)
+  {
+    unsigned i; /* loop counter */
+
+    for (i = 0; i < nofSessions; ++i)
+    {
+      reportLatencies (sessions[i]->name, sessions[i]->state.lockHistogram);
+    }
+
+    return;
+  }
+#endif /* HasPoll */
+
+  reportLatencies ((const char*) 0, lockHistogram);
+}
+
+static void
+lockSecured (Display* d)
+{
+  static Bool reporting = False; /* whether reportLockLatency is set up */
+
+  if (!reporting)
+  {
+    reporting = True;
+    (void) atexit (reportLockLatency);
+  }
+
+  addToHistogram (lockHistogram, 
+                  (long) ((preciseTime () - lockDecided) * 1e6));
+  unwatchRoots (d);
+}
+
+/*
+ *  Function for finding out whether we are waiting for the locker 
+ *  to show up, in which case the main loop should wake up as soon
+ *  as the server has something to say.
+ */
+Bool
+awaitingLocker (void)
+{
+  return watchingRoots;
+}
+
+/*
+ *  Function for dealing with the events that may come in no
+ *  matter how we're detecting user activity. Each mode of 
+ *  operation passes on whatever it doesn't need itself.
+ */
+void
+handleEvent (Display* d, XEvent* event)
+{
+  if (processPointerEvent (event) || processMonitorEvent (event)) return;
+
+  if (watchingRoots && event->type == MapNotify)
+  {
+    int s; /* screen counter */
+
+    for (s = 0; s < ScreenCount (d); ++s)
+    {
+      if (event->xmap.event == RootWindow (d, s))
+      {
+        lockSecured (d);
+        break;
+      }
+    }
+  }
+
+  (void) processMessage (d, event);
+}
+
 /*
  *  Function for querying the idle time from the server.
  *  Only used if either the Xidle or the Xscreensaver
@@ -33,6 +261,8 @@ queryIdleTime (Display* d, Bool use_xidle)
 {
   Time idleTime = 0; /* millisecs since last input event */
 
+  countRoundTrip (xs_engine);
+
 #ifdef HasXidle
   if (use_xidle)
   {
@@ -42,17 +272,15 @@ queryIdleTime (Display* d, Bool use_xidle)
 #endif /* HasXIdle */
   {
 #ifdef HasScreenSaver
-    static XScreenSaverInfo* mitInfo = 0; 
-    if (!mitInfo) mitInfo = XScreenSaverAllocInfo ();
-    XScreenSaverQueryInfo (d, DefaultRootWindow (d), mitInfo);
-    idleTime = mitInfo->idle;
+    XScreenSaverInfo mitInfo; /* as it says */
+
+    if (!XScreenSaverQueryInfo (d, DefaultRootWindow (d), &mitInfo)) return;
+    idleTime = mitInfo.idle;
 #endif /* HasScreenSaver */
   }
 
-  if (idleTime < 1000)  
-  {
-    resetTriggers ();
-  }
+  probe1 (idle_query, (long) idleTime);
+  processIdleTime (idleTime, prevQuery && currentTime () - prevQuery <= 2);
 }
 
 /*
@@ -61,8 +289,75 @@ queryIdleTime (Display* d, Bool use_xidle)
  *  related user activity. The latter actually is only needed when
  *  we're using the DIY mode of operations, but it's much simpler
  *  to do it unconditionally.
+ *
+ *  If the server can tell us when the pointer moves (see xinput.c),
+ *  we only ask where it is after it did. In between, the pointer is
+ *  known to sit where we last saw it, so we can keep acting on the 
+ *  corner it is in (if any) without bothering the server at all,
+ *  unless the settings got reloaded and the zones may have changed.
+ *  Returns whether the server told us about the pointer moving.
  */
-void 
+static Window    pointerRoot;           /* root window it is on      */
+static Screen*   pointerScreen;         /* screen it is on           */
+static unsigned  prevMask = 0;          /* as it says                */
+static int       prevRootX = -1;        /* as it says                */
+static int       prevRootY = -1;        /* as it says                */
+static Bool      firstCall = True;      /* as it says                */
+static Bool      pointerEvents = False; /* whether we hear of moves  */
+static Bool      pointerMoved = False;  /* whether it moved since    */
+static Bool      inZone = False;        /* whether it is in a zone   */
+static zoneBox   pointerZone;           /* which one                 */
+static unsigned  zonesReloaded = 0;     /* reloads it was found for  */
+
+void
+usePointerEvents (void)
+{
+  pointerEvents = True;
+}
+
+void
+notePointerMotion (void)
+{
+  pointerMoved = True;
+}
+
+/*
+ *  Act according to the zone (or corner) the pointer is in. When
+ *  polling, the pointer may already have been sitting in it for up
+ *  to a second by the time we notice, which is what `slack' is about.
+ */
+static void
+applyZone (time_t slack)
+{
+  time_t now;        /* as it says        */
+  time_t newTrigger; /* temporary storage */
+
+  if (!inZone) return;
+
+  switch (pointerZone.action)
+  {
+    case ca_forceLock:
+      now = currentTime ();
+      newTrigger =   now 
+                   + (useRedelay ? pointerZone.redelay : pointerZone.delay)
+                   - slack;
+
+      if (newTrigger < lockTrigger)
+      {
+        setLockTrigger (newTrigger - now);
+      }
+      break;
+
+    case ca_dontLock:
+      resetTriggers ();
+
+#ifdef __GNUC__
+    default: break; /* Makes gcc -Wall shut up. */
+#endif /* __GNUC__ */
+  }
+}
+
+Bool
 queryPointer (Display* d)
 {
   Window           dummyWin;         /* as it says                    */
@@ -70,16 +365,10 @@ queryPointer (Display* d)
   unsigned         mask;             /* modifier mask                 */
   int              rootX;            /* as it says                    */
   int              rootY;            /* as it says                    */
-  int              corner;           /* corner index                  */
-  time_t           now;              /* as it says                    */
-  time_t           newTrigger;       /* temporary storage             */
   int              i;                /* loop counter                  */
-  static Window    root;             /* root window the pointer is on */
-  static Screen*   screen;           /* screen the pointer is on      */
-  static unsigned  prevMask = 0;     /* as it says                    */
-  static int       prevRootX = -1;   /* as it says                    */
-  static int       prevRootY = -1;   /* as it says                    */
-  static Bool      firstCall = True; /* as it says                    */
+  Window           root;             /* as it says                    */
+  Screen*          screen;           /* as it says                    */
+  Bool             told;             /* whether we heard of a move    */
 
  /*
   *  Have a guess...
@@ -87,15 +376,27 @@ queryPointer (Display* d)
   if (firstCall)
   {
     firstCall = False;
-    root = DefaultRootWindow (d);
-    screen = ScreenOfDisplay (d, DefaultScreen (d));
+    pointerRoot = DefaultRootWindow (d);
+    pointerScreen = ScreenOfDisplay (d, DefaultScreen (d));
   }
+  else if (pointerEvents && !pointerMoved && zonesReloaded == reloads)
+  {
+    applyZone (0);
+    return False;
+  }
+
+  told = pointerMoved;
+  pointerMoved = False;
+  root = pointerRoot;
+  screen = pointerScreen;
 
  /*
   *  Find out whether the pointer has moved. Using XQueryPointer for this
   *  is gross, but it also is the only way never to mess up propagation
   *  of pointer events.
   */
+  countRoundTrip (xs_engine);
+
   if (!XQueryPointer (d, root, &root, &dummyWin, &rootX, &rootY,
                       &dummyInt, &dummyInt, &mask))
   {
@@ -110,79 +411,461 @@ queryPointer (Display* d)
         break;
       }
     }
+
+    pointerRoot = root;
+    pointerScreen = screen;
   }
 
+  inZone = whichZone (d, screen, rootX, rootY, &pointerZone);
+  zonesReloaded = reloads;
+  probe3 (pointer_query, rootX, rootY,
+          inZone ? (int) pointerZone.action : -1);
+
   if (   rootX == prevRootX
       && rootY == prevRootY
       && mask == prevMask)
   {
    /*
     *  If the pointer has not moved since the previous call and 
-    *  is inside one of the 4 corners, we act according to the
-    *  contents of the "corners" array.
-    *
-    *  If rootX and rootY are less than zero, don't lock even if
-    *  ca_forceLock is set in the upper-left corner. Why? 'cause
-    *  on initial server startup, if (and only if) the pointer is
-    *  never moved, XQueryPointer() can return values less than 
-    *  zero (only some servers, Openwindows 2.0 and 3.0 in 
-    *  particular).
+    *  is inside one of the corners or zones, we act accordingly.
     */
-    if (   (corner = 0,
-               rootX <= cornerSize && rootX >= 0
-            && rootY <= cornerSize && rootY >= 0)
-        || (corner++,
-               rootX >= WidthOfScreen  (screen) - cornerSize - 1
-            && rootY <= cornerSize)
-        || (corner++,
-               rootX <= cornerSize
-            && rootY >= HeightOfScreen (screen) - cornerSize - 1)
-        || (corner++,
-               rootX >= WidthOfScreen  (screen) - cornerSize - 1
-            && rootY >= HeightOfScreen (screen) - cornerSize - 1))
+    applyZone (pointerEvents ? 0 : 1);
+    return told;
+  }
+
+  useRedelay = False;
+  prevRootX = rootX;
+  prevRootY = rootY;
+  prevMask = mask;
+
+  noteActivity ();
+  resetTriggers ();
+
+ /*
+  *  When told about moves, the dwell time in a corner starts right 
+  *  away, rather than once we've seen the pointer stand still.
+  */
+  if (pointerEvents) applyZone (0);
+
+  return True;
+}
+
+#ifdef HasPosixSpawn
+/*
+ *  Function for starting a pre-parsed command without the help of a 
+ *  shell. Returns the process id, or 0 if that didn't work out (in
+ *  which case the caller should fall back to the shell, e.g. because
+ *  the command turned out to be a shell builtin).
+ */
+extern char** environ;
+
+static unsigned nofOtherChildren = 0; /* notifiers and killers */
+
+static pid_t
+spawnCommand (Display* d, char** argv)
+{
+  pid_t                      pid;     /* as it says */
+  posix_spawn_file_actions_t actions; /* as it says */
+
+  (void) posix_spawn_file_actions_init (&actions);
+  (void) posix_spawn_file_actions_addclose (&actions, ConnectionNumber (d));
+
+  if (posix_spawnp (&pid, argv[0], &actions, 0, argv, environ)) pid = 0;
+
+  (void) posix_spawn_file_actions_destroy (&actions);
+  return pid;
+}
+
+/*
+ *  Same thing for the notifier and the killer, which are fire and 
+ *  forget. Unlike the shell versions, these are our own children, 
+ *  so we have to reap them ourselves. In multi-display mode, that
+ *  would get in the way of reaping the lockers of the other displays
+ *  (see reapChildren ()), so there we leave them to the shell.
+ */
+static void
+runCommand (Display* d, char** argv, const char* shellCommand)
+{
+  if (argv && !displayList && spawnCommand (d, argv))
+  {
+    ++nofOtherChildren;
+  }
+  else
+  {
+    { int dummy; dummy = system (shellCommand); } // Silly gcc...
+  }
+}
+#endif /* HasPosixSpawn */
+
+#ifndef VMS
+/*
+ *  Warm standby support. With -warmlocker, we keep a child process 
+ *  around that has already been forked and has already closed the 
+ *  X connection, and which sits waiting on a pipe for us to tell it
+ *  which locker to run. Starting the locker then only takes a write
+ *  and an exec, rather than a fork of our own and of a shell. The 
+ *  child also holds the write end of a second pipe, which gets closed
+ *  as soon as the exec succeeds, so that we can tell when it did.
+ */
+static struct
+{
+  pid_t        pid;      /* process id of the parked child, or 0 */
+  int          go;       /* write end of the command pipe        */
+  int          ready;    /* read end of the exec pipe            */
+} warm = { 0, -1, -1 };
+
+#define WARM_LOCKER     'L' /* run the locker    */
+#define WARM_NOWLOCKER  'N' /* run the nowlocker */
+
+static void
+runParkedLocker (char command)
+{
+  char** argv = command == WARM_NOWLOCKER ? nowLockerArgv : lockerArgv;
+
+  if (argv) (void) execvp (argv[0], argv);
+
+  (void) execl ("/bin/sh", "/bin/sh", "-c", 
+                (command == WARM_NOWLOCKER ? nowLocker : locker), (void*) 0);
+}
+
+/*
+ *  Everything we've marked close-on-exec (the X connections, the 
+ *  journal, the control and metrics sockets, the self pipe, ...) is
+ *  none of the locker's business. A parked child would hang on to 
+ *  all of that until it gets to exec the locker though, so it drops
+ *  the lot straight away.
+ *
+ *  The limit on open files may well run into the millions, so rather
+ *  than trying each and every one, ask the kernel which ones are
+ *  actually open where we can. Elsewhere, we can live with missing
+ *  the odd one beyond MAX_PARENT_FD, since it'll be closed on exec
+ *  anyway.
+ */
+#define MAX_PARENT_FD 4096
+
+static void
+closeIfCloexec (int fd)
+{
+  int flags; /* as it says */
+
+  if ((flags = fcntl (fd, F_GETFD)) >= 0 && (flags & FD_CLOEXEC))
+  {
+    (void) close (fd);
+  }
+}
+
+static void
+closeParentFds (void)
+{
+  long           max = sysconf (_SC_OPEN_MAX); /* as it says   */
+  int            fd;                           /* loop counter */
+#ifdef __linux__
+  DIR*           dir;                          /* as it says   */
+  struct dirent* entry;                        /* as it says   */
+
+  if ((dir = opendir ("/proc/self/fd"))) /* = intended */
+  {
+    while ((entry = readdir (dir))) /* = intended */
     {
-      now = time (0);
+      if (!isdigit ((unsigned char) entry->d_name[0])) continue;
 
-      switch (corners[corner])
+      if ((fd = atoi (entry->d_name)) >= 3 && fd != dirfd (dir))
       {
-        case ca_forceLock:
-          newTrigger = now + (useRedelay ? cornerRedelay : cornerDelay) - 1;
+        closeIfCloexec (fd);
+      }
+    }
 
-          if (newTrigger < lockTrigger)
-          {
-            setLockTrigger (newTrigger - now);
-          }
-          break;
+    (void) closedir (dir);
+    return;
+  }
+#endif /* __linux__ */
 
-        case ca_dontLock:
-          resetTriggers ();
+  if (max < 0 || max > MAX_PARENT_FD) max = MAX_PARENT_FD;
 
-#ifdef __GNUC__
-	default: break; /* Makes gcc -Wall shut up. */
-#endif /* __GNUC__ */
+  for (fd = 3; fd < max; ++fd)
+  {
+    closeIfCloexec (fd);
+  }
+}
+
+static void
+parkLocker (Display* d)
+{
+  int  go[2];    /* command pipe */
+  int  ready[2]; /* exec pipe    */
+  char command;  /* as it says   */
+
+  if (pipe (go)) return;
+
+  if (pipe (ready))
+  {
+    (void) close (go[0]);
+    (void) close (go[1]);
+    return;
+  }
+
+  switch (warm.pid = fork ())
+  {
+    case -1:
+      warm.pid = 0;
+      (void) close (go[0]);
+      (void) close (go[1]);
+      (void) close (ready[0]);
+      (void) close (ready[1]);
+      return;
+
+    case 0:
+      (void) signal (SIGHUP, SIG_DFL);
+      (void) close (ConnectionNumber (d));
+      (void) close (go[1]);
+      (void) close (ready[0]);
+      closeParentFds ();
+      (void) fcntl (ready[1], F_SETFD, FD_CLOEXEC);
+
+     /*
+      *  Anything but a command (i.e. our parent going away or 
+      *  changing its mind) means that we are not needed.
+      */
+      if (read (go[0], &command, 1) == 1)
+      {
+        (void) close (go[0]);
+        runParkedLocker (command);
       }
-    }
+
+      _exit (EXIT_FAILURE);
+
+    default:
+      (void) close (go[0]);
+      (void) close (ready[1]);
+      (void) fcntl (go[1], F_SETFD, FD_CLOEXEC);
+      (void) fcntl (ready[0], F_SETFD, FD_CLOEXEC);
+      warm.go = go[1];
+      warm.ready = ready[0];
+  }
+}
+
+static void
+forgetParkedLocker (void)
+{
+  (void) close (warm.go);
+  (void) close (warm.ready);
+  warm.pid = 0;
+  warm.go = warm.ready = -1;
+}
+
+/*
+ *  Hand the lock over to the parked child. Returns its process id,
+ *  or 0 if there was no usable parked child. Like vfork(), this only
+ *  returns once the child has exec'ed the locker (or failed to do so).
+ */
+static pid_t
+wakeParkedLocker (void)
+{
+  pid_t pid = warm.pid; /* as it says */
+  char  command;        /* as it says */
+
+  if (!pid) return 0;
+
+ /*
+  *  Nobody may have been looking while it was parked.
+  */
+  if (waitpid (pid, 0, WNOHANG) == pid)
+  {
+    forgetParkedLocker ();
+    return 0;
+  }
+
+  command = lockNow ? WARM_NOWLOCKER : WARM_LOCKER;
+
+  if (write (warm.go, &command, 1) != 1)
+  {
+    (void) kill (pid, SIGKILL);
+    pid = 0;
   }
   else
   {
-    useRedelay = False;
-    prevRootX = rootX;
-    prevRootY = rootY;
-    prevMask = mask;
+    while (read (warm.ready, &command, 1) < 0 && errno == EINTR)
+    {
+      /* wait for the exec */
+    }
+  }
 
-    resetTriggers ();
+  forgetParkedLocker ();
+  return pid;
+}
+
+/*
+ *  Send the parked child (if any) home. It exits as soon as it sees
+ *  the command pipe being closed, so the wait is a short one.
+ */
+static void
+dismissParkedLocker (void)
+{
+  pid_t pid = warm.pid; /* as it says */
+
+  if (!pid) return;
+
+  forgetParkedLocker ();
+  (void) waitpid (pid, 0, 0);
+}
+#endif /* !VMS */
+
+#ifndef VMS
+/*
+ *  Function for collecting any children that have exited, which may
+ *  include the locker. Returns whether it did, and if so, whether
+ *  it exited normally.
+ *
+ *  In multi-display mode, the other children may well be lockers
+ *  of other displays, so we only go looking for our own locker.
+ */
+static Bool
+reapChildren (Bool* lockerOk)
+{
+  Bool  lockerDone = False; /* as it says                 */
+  pid_t pid;                /* process id of a dead child */
+  int   exitCode;           /* as the shell would see it  */
+  pid_t wanted = displayList ? lockerPid : -1;
+                            /* which one(s) to wait for   */
+#if !defined (UTEKV) && !defined (SYSV) && !defined (SVR4)
+  union wait  status;       /* childs process status      */
+
+  while ((pid = wait4 (wanted, &status, WNOHANG, 0)) > 0) /* = intended */
+#else /* !UTEKV && !SYSV && !SVR4 */
+  int         status = 0;   /* childs process status      */
+
+  while ((pid = waitpid (wanted, &status, WNOHANG)) > 0) /* = intended */
+#endif /* !UTEKV && !SYSV && !SVR4 */
+  {
+    if (pid == lockerPid)
+    {
+      lockerDone = True;
+      *lockerOk =    WIFEXITED (status) 
+                  && WEXITSTATUS (status) == EXIT_SUCCESS;
+      exitCode =   WIFEXITED (status)   ? WEXITSTATUS (status)
+                 : WIFSIGNALED (status) ? 128 + WTERMSIG (status)
+                 : -1;
+      journal (jr_unlock, (long) exitCode);
+      probe2 (locker_reap, (long) pid, exitCode);
+    }
+    else if (pid == warm.pid)
+    {
+      forgetParkedLocker ();
+    }
+#ifdef HasPosixSpawn
+    else if (nofOtherChildren)
+    {
+      --nofOtherChildren;
+    }
+#endif /* HasPosixSpawn */
+  }
+
+ /*
+  *  No children at all means that the locker is gone too, even
+  *  though we didn't get to see it go.
+  */
+  if (pid < 0 && lockerPid && !lockerDone)
+  {
+    lockerDone = True;
+    *lockerOk = True;
+    journal (jr_unlock, -1);
+  }
+
+  return lockerDone;
+}
+#endif /* !VMS */
+
+/*
+ *  Stuff to be done once the locker has been started.
+ */
+static void
+lockerStarted (Display* d)
+{
+  lockLatency = (long) ((preciseTime () - lockDecided) * 1e6);
+  ++metrics.lockerSpawns;
+  metrics.spawnSeconds += lockLatency / 1e6;
+  journal (jr_lock, (long) lockerPid);
+  probe2 (locker_spawn, (long) lockerPid, lockLatency);
+  noteLockStarted (  lockNow ? ls_lockNow
+                   : inZone && pointerZone.action == ca_forceLock ? ls_corner
+                   : ls_timeout);
+
+#ifdef SYS_pidfd_open
+ /*
+  *  Where possible, get a file descriptor that becomes readable as
+  *  soon as the locker exits, so that the main loop can wait for it
+  *  rather than having to check every second.
+  */
+  lockerFd = (int) syscall (SYS_pidfd_open, lockerPid, 0);
+#endif /* SYS_pidfd_open */
+
+ /*
+  *  In general xautolock should keep its fingers off the real
+  *  screensaver because no universally acceptable policy can 
+  *  be defined. In no case should it decide to disable or enable 
+  *  it all by itself. Setting the screensaver policy is something
+  *  the locker should take care of. After all, xautolock is not
+  *  supposed to know what the "locker" does and doesn't do. 
+  *  People might be using xautolock for totally different
+  *  purposes (which, by the way, is why it will accept a
+  *  different set of X resources after being renamed).
+  *
+  *  Nevertheless, simply resetting the screensaver is a
+  *  convenience action that aids many xlock users, and doesn't
+  *  harm anyone (*). The problem with older versions of xlock 
+  *  is that they can be told to replace (= disable) the real
+  *  screensaver, but forget to reset that same screensaver if
+  *  it was already active at the time xlock starts. I guess 
+  *  xlock initially wasn't designed to be run without a user
+  *  actually typing the comand ;-).
+  *
+  *  (*) Well, at least it used not to harm anyone, but with the
+  *      advent of DPMS monitors, it now can mess up the power
+  *      saving setup. Hence we better make it optional. 
+  *
+  *      Also, some xlock versions also unconditionally call
+  *      XResetScreenSaver, yielding the same kind of problems
+  *      with DPMS that xautolock did. The latest and greatest
+  *      xlocks also have a -resetsaver option for this very
+  *      reason. You may want to upgrade.
+  */
+  if (resetSaver)
+  {
+    (void) XResetScreenSaver(d);
+    countRequests (xs_engine, 1);
   }
+  
+  setLockTrigger (lockTime);
+  (void) XSync (d,0);
+  countRoundTrip (xs_engine);
 }
 
 /*
  *  Support for deciding whether to lock or kill.
  */
+static time_t prevNotification = 0;   /* time of the last notification */
+static time_t journaledActivity = 0;  /* last activity we wrote down    */
+
 void
 evaluateTriggers (Display* d)
 {
-  static time_t prevNotification = 0;
   time_t        now = 0;
 
+ /*
+  *  Without a server telling us how idle the user is (see
+  *  processIdleTime ()), we hear of each and every input event, so
+  *  the time since the previous one is the idle stretch that ended.
+  */
+  if (!prevQuery && lastActivity != journaledActivity)
+  {
+    if (journaledActivity)
+    {
+      endIdleStretch (lastActivity - journaledActivity);
+    }
+
+    journaledActivity = lastActivity;
+  }
+
  /*
   *  Obvious things first.
   *
@@ -210,23 +893,27 @@ evaluateTriggers (Display* d)
 #else /* VMS */
   if (lockerPid)
   {
-#if !defined (UTEKV) && !defined (SYSV) && !defined (SVR4)
-    union wait  status;      /* childs process status */
-#else /* !UTEKV && !SYSV && !SVR4 */
-    int         status = 0;  /* childs process status */
-#endif /* !UTEKV && !SYSV && !SVR4 */
+    Bool lockerOk = False; /* whether the locker exited normally */
 
     if (unlockNow && !disabled)
     {
-      (void) kill (lockerPid, SIGTERM);
+#ifdef SYS_pidfd_send_signal
+      if (   lockerFd >= 0
+          && !syscall (SYS_pidfd_send_signal, lockerFd, SIGTERM, 0, 0))
+      {
+        /* no risk of hitting another process with a recycled pid */
+      }
+      else
+#endif /* SYS_pidfd_send_signal */
+      {
+        (void) kill (lockerPid, SIGTERM);
+      }
     }
 
-#if !defined (UTEKV) && !defined (SYSV) && !defined (SVR4)
-    if (wait3 (&status, WNOHANG, 0))
-#else /* !UTEKV && !SYSV && !SVR4 */
-    if (waitpid (-1, &status, WNOHANG)) 
-#endif /* !UTEKV && !SYSV && !SVR4 */
+    if (reapChildren (&lockerOk))
     {
+      noteLockEnded ();
+
      /*
       *  If the locker exited normally, we disable any pending kill
       *  trigger. Otherwise, we assume that it either has crashed or
@@ -235,14 +922,20 @@ evaluateTriggers (Display* d)
       *  the later cases, disabling the kill trigger would open a
       *  loop hole.
       */
-      if (   WIFEXITED (status)
-	  && WEXITSTATUS (status) == EXIT_SUCCESS)
+      if (lockerOk)
       {
         disableKillTrigger ();
       }
 
       useRedelay = True;
       lockerPid = 0;
+      unwatchRoots (d);
+
+      if (lockerFd >= 0)
+      {
+        (void) close (lockerFd);
+        lockerFd = -1;
+      }
     }
 #endif /* VMS */
 
@@ -258,6 +951,14 @@ evaluateTriggers (Display* d)
 
   unlockNow = False;
 
+#ifdef HasPosixSpawn
+  if (!lockerPid && nofOtherChildren)
+  {
+    Bool dummy; /* as it says */
+    (void) reapChildren (&dummy);
+  }
+#endif /* HasPosixSpawn */
+
  /*
   *  Note that the above lot needs to be done even when we're in 
   *  disabled mode, since we may have entered said mode with an
@@ -268,7 +969,8 @@ evaluateTriggers (Display* d)
  /*
   *  Is it time to run the killer command?
   */
-  now = time (0);
+  now = currentTime ();
+  noteLockPutOff (now);
 
   if (killTrigger && now >= killTrigger)
   {
@@ -278,12 +980,20 @@ evaluateTriggers (Display* d)
     *  we don't want to have it interfere with the wait() stuff we 
     *  do to keep track of the locker. To obtain both, the killer
     *  command has already been patched by KillerChecker() so that
-    *  it gets backgrounded by the shell started by system().
+    *  it gets backgrounded by the shell started by system(). With
+    *  -noshell, simple commands are started directly instead, and
+    *  reaped by reapChildren().
     *
     *  For the time being, VMS users are out of luck: their xautolock
     *  will indeed block until the killer returns.
     */
+#ifdef HasPosixSpawn
+    runCommand (d, killerArgv, killer);
+#else /* HasPosixSpawn */
     { int dummy; dummy = system (killer); } // Silly gcc...
+#endif /* HasPosixSpawn */
+    journal (jr_kill, 0);
+    probe0 (kill);
     setKillTrigger (killTime);
   }
 
@@ -299,14 +1009,23 @@ evaluateTriggers (Display* d)
      /*
       *  Here we use the same dirty trick as for the killer command.
       */
+#ifdef HasPosixSpawn
+      runCommand (d, notifierArgv, notifier);
+#else /* HasPosixSpawn */
       { int dummy; dummy = system (notifier); } // Silly gcc...
+#endif /* HasPosixSpawn */
     }
     else
     {
       (void) XBell (d, bellPercent);
       (void) XSync (d, 0);
+      countRequests (xs_engine, 1);
+      countRoundTrip (xs_engine);
     }
 
+    journal (jr_notify, (long) (lockTrigger - now));
+    probe1 (notify, (long) (lockTrigger - now));
+    noteNotification ();
     prevNotification = now;
   }
 
@@ -322,6 +1041,33 @@ evaluateTriggers (Display* d)
     if (!lockerPid)
 #endif /* VMS */
     {
+#ifdef HasPosixSpawn
+      char** argv = lockNow ? nowLockerArgv : lockerArgv;
+#endif /* HasPosixSpawn */
+
+     /*
+      *  If we were told to lock, the clock started ticking back then.
+      */
+      lockDecided = lockNow && lockRequested ? lockRequested 
+                                             : preciseTime ();
+      lockRequested = 0.0;
+      probe1 (lock, lockNow ? 1 : 0);
+      watchRoots (d);
+
+#ifndef VMS
+      if (warmLocker && (lockerPid = wakeParkedLocker ())) /* = intended */
+      {
+        lockerStarted (d);
+      }
+      else
+#endif /* VMS */
+#ifdef HasPosixSpawn
+      if (argv && (lockerPid = spawnCommand (d, argv))) /* = intended */
+      {
+        lockerStarted (d);
+      }
+      else
+#endif /* HasPosixSpawn */
       switch (lockerPid = vfork ())
       {
         case -1:
@@ -347,41 +1093,16 @@ evaluateTriggers (Display* d)
           _exit (EXIT_FAILURE);
   
         default:
-         /*
-          *  In general xautolock should keep its fingers off the real
-          *  screensaver because no universally acceptable policy can 
-          *  be defined. In no case should it decide to disable or enable 
-          *  it all by itself. Setting the screensaver policy is something
-          *  the locker should take care of. After all, xautolock is not
-          *  supposed to know what the "locker" does and doesn't do. 
-          *  People might be using xautolock for totally different
-          *  purposes (which, by the way, is why it will accept a
-          *  different set of X resources after being renamed).
-          *
-          *  Nevertheless, simply resetting the screensaver is a
-          *  convenience action that aids many xlock users, and doesn't
-          *  harm anyone (*). The problem with older versions of xlock 
-	  *  is that they can be told to replace (= disable) the real
-	  *  screensaver, but forget to reset that same screensaver if
-	  *  it was already active at the time xlock starts. I guess 
-	  *  xlock initially wasn't designed to be run without a user
-	  *  actually typing the comand ;-).
-	  *
-	  *  (*) Well, at least it used not to harm anyone, but with the
-	  *      advent of DPMS monitors, it now can mess up the power
-	  *      saving setup. Hence we better make it optional. 
-	  *
-	  *      Also, some xlock versions also unconditionally call
-	  *      XResetScreenSaver, yielding the same kind of problems
-	  *      with DPMS that xautolock did. The latest and greatest
-	  *      xlocks also have a -resetsaver option for this very
-	  *      reason. You may want to upgrade.
-          */
-	  if (resetSaver) (void) XResetScreenSaver(d);
-  
-          setLockTrigger (lockTime);
-          (void) XSync (d,0);
+          lockerStarted (d);
+      }
+
+#ifndef VMS
+      if (!lockerPid)
+      {
+        ++metrics.spawnFailures;
+        unwatchRoots (d);
       }
+#endif /* VMS */
 
      /*
       *  Once the locker is running, all that needs to be done is to 
@@ -396,4 +1117,172 @@ evaluateTriggers (Display* d)
 
     lockNow = False;
   }
+
+#ifndef VMS
+ /*
+  *  Make sure there is a parked locker whenever we may need one. 
+  *  Doing this after the fact rather than shortly before the lock
+  *  trigger goes off also covers -locknow and the corners.
+  */
+  if (warmLocker)
+  {
+    if (disabled)
+    {
+      dismissParkedLocker ();
+    }
+    else if (!lockerPid && !warm.pid)
+    {
+      parkLocker (d);
+    }
+  }
+#endif /* VMS */
+}
+
+/*
+ *  Function for finding out how many seconds may pass before 
+ *  evaluateTriggers() needs to be called again, assuming that
+ *  nothing happens in the mean time. Only used in tickless mode.
+ */
+time_t
+timeToNextTrigger (void)
+{
+  time_t now = currentTime (); /* as it says            */
+  time_t next;                 /* earliest next trigger */
+
+  next = lockTrigger;
+
+  if (notifyLock && lockTrigger - notifyMargin > now)
+  {
+    next = lockTrigger - notifyMargin;
+  }
+
+  if (killTrigger && killTrigger < next)
+  {
+    next = killTrigger;
+  }
+
+ /*
+  *  Never return 0. Because time() truncates, we might otherwise
+  *  end up spinning during the last fraction of a second.
+  */
+  return next > now ? next - now : 1;
+}
+
+/*
+ *  Function for taking new settings on board (see -reload) without
+ *  losing track of where we are. Triggers keep on running, only as
+ *  far from the last activity as the new times say, and a running
+ *  locker remains ours to look after. A parked one (see parkLocker ())
+ *  was forked with the old settings, though. Returns whether the new
+ *  settings were taken.
+ */
+Bool
+reloadSettings (Display* d)
+{
+  time_t   lockDelta = lockTime; /* as it says   */
+  time_t   killDelta = killTime; /* as it says   */
+#ifdef HasPoll
+  unsigned i;                    /* loop counter */
+#endif /* HasPoll */
+
+  if (!reloadOpts (d)) return False;
+
+  lockDelta = lockTime - lockDelta;
+  killDelta = killTime - killDelta;
+
+  lockTrigger += lockDelta;
+  if (killTrigger) killTrigger += killDelta;
+  if (!killerSpecified) disableKillTrigger ();
+
+#ifdef HasPoll
+ /*
+  *  The display at hand (if any) gets its state saved when we leave
+  *  it, so adjusting the saved state of all of them is fine.
+  */
+  for (i = 0; i < nofSessions; ++i)
+  {
+    displayState* state = &sessions[i]->state; /* as it says */
+
+    state->lockTrigger += lockDelta;
+    if (state->killTrigger) state->killTrigger += killDelta;
+    if (!killerSpecified) state->killTrigger = 0;
+  }
+#endif /* HasPoll */
+
+#ifndef VMS
+  dismissParkedLocker ();
+#endif /* VMS */
+
+  return True;
+}
+
+/*
+ *  Functions for switching between displays in multi-display mode.
+ */
+void
+saveEngineState (engineState* s)
+{
+  s->prevQuery = prevQuery;
+  s->idleFrom = idleFrom;
+  s->idleSeen = idleSeen;
+  s->pointerRoot = pointerRoot;
+  s->pointerScreen = pointerScreen;
+  s->prevMask = prevMask;
+  s->prevRootX = prevRootX;
+  s->prevRootY = prevRootY;
+  s->firstCall = firstCall;
+  s->pointerEvents = pointerEvents;
+  s->pointerMoved = pointerMoved;
+  s->inZone = inZone;
+  s->pointerZone = pointerZone;
+  s->zonesReloaded = zonesReloaded;
+  s->useRedelay = useRedelay;
+  s->prevNotification = prevNotification;
+  s->journaledActivity = journaledActivity;
+  s->lockDecided = lockDecided;
+  s->rootMasks = rootMasks;
+  s->watchingRoots = watchingRoots;
+#ifdef HasPosixSpawn
+  s->nofOtherChildren = nofOtherChildren;
+#endif /* HasPosixSpawn */
+}
+
+void
+loadEngineState (const engineState* s)
+{
+  prevQuery = s->prevQuery;
+  idleFrom = s->idleFrom;
+  idleSeen = s->idleSeen;
+  pointerRoot = s->pointerRoot;
+  pointerScreen = s->pointerScreen;
+  prevMask = s->prevMask;
+  prevRootX = s->prevRootX;
+  prevRootY = s->prevRootY;
+  firstCall = s->firstCall;
+  pointerEvents = s->pointerEvents;
+  pointerMoved = s->pointerMoved;
+  inZone = s->inZone;
+  pointerZone = s->pointerZone;
+  zonesReloaded = s->zonesReloaded;
+  useRedelay = s->useRedelay;
+  prevNotification = s->prevNotification;
+  journaledActivity = s->journaledActivity;
+  lockDecided = s->lockDecided;
+  rootMasks = s->rootMasks;
+  watchingRoots = s->watchingRoots;
+#ifdef HasPosixSpawn
+  nofOtherChildren = s->nofOtherChildren;
+#endif /* HasPosixSpawn */
+}
+
+/*
+ *  Function for getting a fresh engineState, as if we had only just
+ *  started looking after the display.
+ */
+void
+initEngineState (engineState* s)
+{
+  (void) memset (s, 0, sizeof (*s));
+  s->prevRootX = s->prevRootY = -1;
+  s->firstCall = True;
 }
@@ -0,0 +1,103 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It implements
+ *          the stuff used for keeping track of how things (like the
+ *          time it takes to lock the screen) are distributed.
+ *
+ *          Values are counted in buckets that grow exponentially, each
+ *          power of two being split into HISTOGRAM_SUB of them. That
+ *          keeps the thing small and of fixed size, no matter how many
+ *          values are added, while any percentile can still be told to
+ *          within 1/HISTOGRAM_SUB of the real thing.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#include "histogram.h"
+
+#define SUB_BITS  3  /* log2 (HISTOGRAM_SUB) */
+
+/*
+ *  Find the bucket a value belongs in. Small values get one each,
+ *  all others are split according to their highest bit and the
+ *  SUB_BITS bits that follow it.
+ */
+static unsigned
+bucketOf (long value)
+{
+  unsigned long v = value < 0 ? 0 : (unsigned long) value;
+  unsigned      top = 0;    /* highest bit set in v */
+  unsigned      bucket;     /* as it says           */
+
+  if (v < HISTOGRAM_SUB) return (unsigned) v;
+
+  while (v >> (top + 1)) ++top;
+
+  bucket =   (top - SUB_BITS + 1) * HISTOGRAM_SUB
+           + (unsigned) (v >> (top - SUB_BITS)) - HISTOGRAM_SUB;
+
+  return bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1;
+}
+
+/*
+ *  Find the largest value that belongs in a bucket.
+ */
+static long
+bucketLimit (unsigned bucket)
+{
+  unsigned shift; /* as it says */
+
+  if (bucket < HISTOGRAM_SUB) return (long) bucket;
+
+  shift = bucket / HISTOGRAM_SUB - 1;
+  return (long) (((unsigned long) (bucket % HISTOGRAM_SUB + HISTOGRAM_SUB + 1)
+                  << shift) - 1);
+}
+
+void
+addToHistogram (histogram* h, long value)
+{
+  ++h->counts[bucketOf (value)];
+  ++h->total;
+
+  if (value > h->max) h->max = value;
+}
+
+/*
+ *  Find the value below which the given percentage of all values 
+ *  lies, rounded up to the end of its bucket (but never beyond the
+ *  largest value seen). Returns -1 if there are no values at all.
+ */
+long
+histogramPercentile (const histogram* h, unsigned percent)
+{
+  unsigned long needed; /* number of values to cover */
+  unsigned long seen;   /* number covered so far     */
+  unsigned      i;      /* loop counter              */
+  long          limit;  /* as it says                */
+
+  if (!h->total) return -1;
+
+  needed = (h->total * percent + 99) / 100;
+  if (!needed) needed = 1;
+
+  for (i = 0, seen = 0; i < HISTOGRAM_BUCKETS; ++i)
+  {
+    if ((seen += h->counts[i]) >= needed) break;
+  }
+
+  limit = bucketLimit (i);
+  return limit < h->max ? limit : h->max;
+}
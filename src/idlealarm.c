@@ -0,0 +1,283 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It implements
+ *          the stuff used when the program lets the SYNC extension tell
+ *          it about user (in)activity instead of asking for it.
+ *
+ *          The basic idea is that the server maintains an IDLETIME
+ *          counter, on which we place two alarms. The first one goes
+ *          off once the user has been idle for long enough for the 
+ *          next trigger to be due. The second one goes off when the
+ *          user becomes active again after having been idle for at 
+ *          least as long as the first alarm was set to. This way, the
+ *          server stays silent both while the user is busy and while
+ *          nobody is around, and we never need to ask it for anything.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ * 
+ * --------------------------------------------------------------------------
+ * 
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ * 
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#include "idlealarm.h"
+#include "engine.h"
+#include "state.h"
+#include "options.h"
+#include "miscutil.h"
+
+#ifdef HasSync
+
+static struct
+{
+  XSyncCounter counter;    /* the IDLETIME system counter            */
+  XSyncAlarm   idleAlarm;  /* positive transition, next trigger due  */
+  XSyncAlarm   busyAlarm;  /* negative transition, activity resumed  */
+  int          eventBase;  /* first SYNC event number                */
+  time_t       lastInput;  /* best guess at time of last input event */
+  Time         idleValue;  /* current setting of idleAlarm           */
+  Time         busyValue;  /* current setting of busyAlarm           */
+  Bool         idleKnown;  /* whether busyAlarm covers lastInput     */
+  Bool         inUse;      /* whether the alarms are in place        */
+} alarms;
+
+/*
+ *  Alarm management. Counter values are 64 bits wide, so that a 
+ *  timeout of more than 2^31 milliseconds (some 25 days, which is
+ *  well within reach of -time and -killtime) doesn't get truncated.
+ *  The double shift keeps things defined where a Time is 32 bits.
+ */
+static void
+timeToValue (XSyncValue* v, Time value)
+{
+  XSyncIntsToValue (v, (unsigned int) (value & 0xffffffffUL),
+                    (int) (value >> 16 >> 16));
+}
+
+static XSyncAlarm
+createAlarm (Display* d, XSyncTestType test, Time value)
+{
+  XSyncAlarmAttributes attribs;
+
+  attribs.trigger.counter = alarms.counter;
+  attribs.trigger.value_type = XSyncAbsolute;
+  attribs.trigger.test_type = test;
+  timeToValue (&attribs.trigger.wait_value, value);
+  XSyncIntToValue (&attribs.delta, 0);
+  attribs.events = True;
+
+  return XSyncCreateAlarm (d,   XSyncCACounter | XSyncCAValueType
+                              | XSyncCATestType | XSyncCAValue
+                              | XSyncCADelta | XSyncCAEvents,
+                           &attribs);
+}
+
+static void
+setAlarm (Display* d, XSyncAlarm alarm, Time* current, Time value)
+{
+  XSyncAlarmAttributes attribs;
+
+ /*
+  *  Don't bother the server if nothing changes.
+  */
+  if (*current == value) return;
+
+  timeToValue (&attribs.trigger.wait_value, value);
+  (void) XSyncChangeAlarm (d, alarm, XSyncCAValue, &attribs);
+  *current = value;
+}
+
+/*
+ *  Function for dealing with what the server tells us (or what we
+ *  had to ask it after all). Alarms go off as soon as there is
+ *  anything to tell, but asking only tells us how things are now.
+ */
+static void
+learnIdleTime (Time idleTime, Bool asked)
+{
+  alarms.lastInput = currentTime () - (time_t) (idleTime / 1000);
+  processIdleTime (idleTime, !asked);
+}
+
+/*
+ *  Function for asking the server how idle the user is, for when we
+ *  aren't sure whether the user has been active in the mean time.
+ */
+static void
+askIdleTime (Display* d)
+{
+  XSyncValue value;    /* counter value                */
+  Time       idleTime; /* millisecs since last input   */
+
+  if (XSyncQueryCounter (d, alarms.counter, &value))
+  {
+    idleTime = (Time) XSyncValueLow32 (value);
+    learnIdleTime (idleTime, True);
+
+    if (idleTime >= 1000)
+    {
+      setAlarm (d, alarms.busyAlarm, &alarms.busyValue, idleTime);
+      alarms.idleKnown = True;
+    }
+  }
+}
+
+/*
+ *  Function for processing any events that have come in since last
+ *  time, and for moving the alarms to match the triggers. It is 
+ *  crucial that this function does not block in case nothing
+ *  interesting happened.
+ */
+void
+processAlarms (Display* d)
+{
+  XEvent                 event;     /* as it says                   */
+  XSyncAlarmNotifyEvent* alarm;     /* as it says                   */
+  Time                   idleTime;  /* millisecs since last input   */
+  time_t                 now;       /* as it says                   */
+  time_t                 nextDue;   /* time at which the next
+                                       trigger is due               */
+
+  while (XPending (d))
+  {
+    (void) XNextEvent (d, &event);
+
+    if (event.type != alarms.eventBase + XSyncAlarmNotify)
+    {
+      handleEvent (d, &event);
+      continue;
+    }
+
+    alarm = (XSyncAlarmNotifyEvent*) &event;
+    idleTime = (Time) XSyncValueLow32 (alarm->counter_value);
+
+    if (alarm->alarm == alarms.idleAlarm)
+    {
+     /*
+      *  The user has been idle for at least as long as we asked for,
+      *  so from now on we are sure to hear about any new input.
+      */
+      learnIdleTime (idleTime, False);
+      setAlarm (d, alarms.busyAlarm, &alarms.busyValue, idleTime);
+      alarms.idleKnown = True;
+    }
+    else if (alarm->alarm == alarms.busyAlarm)
+    {
+     /*
+      *  The user is back. Until the user has been idle for as long as
+      *  the busy alarm is set to, we won't hear about any further input.
+      */
+      learnIdleTime (idleTime, False);
+      alarms.idleKnown = False;
+    }
+  }
+
+ /*
+  *  If some trigger is due while we're not sure whether the user has 
+  *  been active in the mean time, we have no choice but to ask. This 
+  *  only happens if we got woken up for some other reason anyway.
+  */
+  now = currentTime ();
+
+  if (   !alarms.idleKnown
+      && (   now + (notifyLock ? notifyMargin : 0) >= lockTrigger
+          || (killTrigger && now >= killTrigger)))
+  {
+    askIdleTime (d);
+  }
+
+ /*
+  *  Finally make the idle alarm go off when the next trigger is due,
+  *  unless the user happens to do something before that. If there
+  *  was input we don't know about, the alarm simply goes off late, 
+  *  which is exactly what we want.
+  */
+  nextDue = now + timeToNextTrigger ();
+  setAlarm (d, alarms.idleAlarm, &alarms.idleValue, 
+            (Time) (nextDue - alarms.lastInput) * 1000);
+}
+
+#endif /* HasSync */
+
+/*
+ *  Function for bringing lastActivity and the triggers up to date
+ *  before telling anyone about them. While the user is busy, the
+ *  server doesn't tell us a thing, so we may have to ask after all.
+ *  Doesn't do anything unless the alarms are in use.
+ */
+void
+refreshIdleTime (Display* d)
+{
+#ifdef HasSync
+  if (alarms.inUse && !alarms.idleKnown) askIdleTime (d);
+#endif /* HasSync */
+}
+
+/*
+ *  Function for initialising the whole shebang. Returns whether
+ *  the server is able to provide what we need.
+ */
+Bool
+initIdleAlarms (Display* d)
+{
+#ifdef HasSync
+  int                 dummy;       /* as it says                */
+  int                 nofCounters; /* number of system counters */
+  int                 i;           /* loop counter              */
+  XSyncSystemCounter* counters;    /* system counters           */
+  XSyncValue          value;       /* counter value             */
+
+  alarms.counter = None;
+
+  if (   !XSyncQueryExtension (d, &alarms.eventBase, &dummy)
+      || !XSyncInitialize (d, &dummy, &dummy))
+  {
+    return False;
+  }
+
+  if ((counters = XSyncListSystemCounters (d, &nofCounters))) /* = intended */
+  {
+    for (i = -1; ++i < nofCounters; )
+    {
+      if (!strcmp (counters[i].name, "IDLETIME"))
+      {
+        alarms.counter = counters[i].counter;
+        break;
+      }
+    }
+
+    XSyncFreeSystemCounterList (counters);
+  }
+
+  if (   alarms.counter == None
+      || !XSyncQueryCounter (d, alarms.counter, &value))
+  {
+    return False;
+  }
+
+  alarms.lastInput =   currentTime () 
+                     - (time_t) (XSyncValueLow32 (value) / 1000);
+  alarms.idleValue = (Time) (  currentTime () + timeToNextTrigger ()
+                             - alarms.lastInput) * 1000;
+  alarms.busyValue = alarms.idleValue;
+  alarms.idleKnown = False;
+
+  alarms.idleAlarm = createAlarm (d, XSyncPositiveTransition, 
+                                  alarms.idleValue);
+  alarms.busyAlarm = createAlarm (d, XSyncNegativeTransition,
+                                  alarms.busyValue);
+
+  alarms.inUse = alarms.idleAlarm != None && alarms.busyAlarm != None;
+  return alarms.inUse;
+#else /* HasSync */
+  return False;
+#endif /* HasSync */
+}
@@ -0,0 +1,236 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It implements
+ *          the stuff used for keeping a journal of what happened (see
+ *          -journal).
+ *
+ *          Things worth writing down tend to happen right in the middle
+ *          of deciding whether to lock, which is no time to be waiting
+ *          for a disk. So records go into a ring of fixed size first,
+ *          and get appended to the journal in batches from the main
+ *          loop: once enough of them have piled up, once the oldest one
+ *          has been waiting for a while, and when we exit. Should the
+ *          ring ever fill up (say because the disk is full), the records
+ *          that don't fit are counted, and the journal says how many got
+ *          lost as soon as it can be written to again.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#include "config.h"
+#include "journal.h"
+#include "options.h"
+#include "state.h"
+#include "miscutil.h"
+
+#define JOURNAL_RING    512  /* records we can hold on to     */
+#define JOURNAL_BATCH   64   /* records worth a write() call  */
+#define JOURNAL_LINGER  60   /* seconds a record may wait     */
+
+#ifndef VMS
+static journalRecord ring[JOURNAL_RING]; /* as it says                 */
+static unsigned      first = 0;          /* oldest record in the ring  */
+static unsigned      count = 0;          /* records in the ring        */
+static unsigned long lost = 0;           /* records that didn't fit    */
+static time_t        oldest = 0;         /* when the oldest was added  */
+static int           fd = -1;            /* the journal itself         */
+static int           display = -1;       /* display at hand            */
+
+static void
+flushAtExit (void)
+{
+  flushJournal (True);
+}
+
+/*
+ *  Function for filling in a record.
+ */
+static void
+fillRecord (journalRecord* record, journalType type, long value)
+{
+  struct timeval tv; /* as it says */
+
+  (void) gettimeofday (&tv, 0);
+  record->time = (int64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+  record->type = (uint16_t) type;
+  record->display = (int16_t) display;
+  record->value = (int32_t) value;
+}
+
+/*
+ *  Function for appending records to the journal. Either all of them
+ *  make it, or none of them do: whatever a short write left behind
+ *  gets cut off again, so that the journal never ends halfway through
+ *  a record.
+ */
+static Bool
+writeRecords (const journalRecord* records, unsigned n)
+{
+  const char* from = (const char*) records;      /* as it says */
+  size_t      left = n * sizeof (journalRecord); /* as it says */
+  off_t       start = lseek (fd, 0, SEEK_END);   /* as it says */
+  ssize_t     done;                              /* as it says */
+
+  while (left)
+  {
+    if ((done = write (fd, from, left)) < 0 && errno == EINTR) continue;
+
+    if (done <= 0)
+    {
+      if (start >= 0 && from != (const char*) records)
+      {
+        (void) ftruncate (fd, start);
+      }
+
+      return False;
+    }
+
+    from += done;
+    left -= (size_t) done;
+  }
+
+  return True;
+}
+#endif /* VMS */
+
+/*
+ *  Function for opening the journal. Failing to do so isn't fatal,
+ *  we just do without.
+ */
+void
+initJournal (void)
+{
+#ifndef VMS
+  journalHeader header;  /* as it says */
+  struct stat   info;    /* as it says */
+
+  if (!journalFile) return;
+
+  if (   (fd = open (journalFile, O_RDWR | O_APPEND | O_CREAT, 0600)) < 0
+      || fstat (fd, &info) < 0)
+  {
+    error1 ("Couldn't open the journal %s.\n", journalFile);
+    if (fd >= 0) (void) close (fd);
+    fd = -1;
+    return;
+  }
+
+  (void) fcntl (fd, F_SETFD, FD_CLOEXEC);
+
+  if (info.st_size == 0)
+  {
+    (void) memset (&header, 0, sizeof (header));
+    (void) memcpy (header.magic, JOURNAL_MAGIC, sizeof (header.magic));
+    header.version = JOURNAL_VERSION;
+    header.recordSize = sizeof (journalRecord);
+
+    if (write (fd, &header, sizeof (header)) != sizeof (header))
+    {
+      info.st_size = -1;
+    }
+  }
+  else if (   read (fd, &header, sizeof (header)) != sizeof (header)
+           || memcmp (header.magic, JOURNAL_MAGIC, sizeof (header.magic))
+           || header.recordSize != sizeof (journalRecord))
+  {
+    info.st_size = -1;
+  }
+
+  if (info.st_size < 0)
+  {
+    error1 ("%s is not a journal of ours, not using it.\n", journalFile);
+    (void) close (fd);
+    fd = -1;
+    return;
+  }
+
+  (void) atexit (flushAtExit);
+#endif /* VMS */
+}
+
+/*
+ *  Function for telling which display the next records are about.
+ */
+void
+journalDisplay (const char* name)
+{
+#ifndef VMS
+  const char* colon = strrchr (name, ':'); /* as it says */
+
+  display = colon ? atoi (colon + 1) : -1;
+#endif /* VMS */
+}
+
+/*
+ *  Function for adding a record. This never blocks.
+ */
+void
+journal (journalType type, long value)
+{
+#ifndef VMS
+  if (fd < 0) return;
+
+  if (count == JOURNAL_RING)
+  {
+    ++lost;
+    return;
+  }
+
+  if (!count) oldest = currentTime ();
+
+  fillRecord (&ring[(first + count++) % JOURNAL_RING], type, value);
+#endif /* VMS */
+}
+
+/*
+ *  Function for writing out what has piled up, if it's about time.
+ *  Whatever can't be written stays in the ring for the next attempt,
+ *  and so does the news of records lost meanwhile.
+ */
+void
+flushJournal (Bool now)
+{
+#ifndef VMS
+  journalRecord record; /* for reporting losses      */
+  unsigned      n;      /* records to write in one go */
+
+  if (fd < 0 || (!count && !lost)) return;
+
+  if (   !now
+      && count < JOURNAL_BATCH
+      && (!count || currentTime () - oldest < JOURNAL_LINGER))
+  {
+    return;
+  }
+
+  while (count)
+  {
+    n = MIN (count, JOURNAL_RING - first);
+
+    if (!writeRecords (&ring[first], n)) return;
+
+    first = (first + n) % JOURNAL_RING;
+    count -= n;
+  }
+
+  first = 0;
+
+  if (lost)
+  {
+    fillRecord (&record, jr_lost, (long) lost);
+    if (writeRecords (&record, 1)) lost = 0;
+  }
+#endif /* VMS */
+}
@@ -19,207 +19,440 @@
  *****************************************************************************/
 
 #include "message.h"
+#include "control.h"
+#include "engine.h"
 #include "state.h"
 #include "options.h"
+#include "journal.h"
+#include "metrics.h"
 #include "miscutil.h"
 
 static Atom semaphore;   /* semaphore property for locating 
                             an already running xautolock    */
-static Atom messageAtom; /* message property for talking to
-                            an already running xautolock    */
+static Atom messageAtom; /* message type for talking to an
+                            already running xautolock       */
+static Atom windowAtom;  /* window property for locating the
+                            window to send messages to      */
+static Bool sendFailed;  /* whether sending a message failed */
 
 #define SEM_PID "_SEMAPHORE_PID"  
 #define MESSAGE "_MESSAGE"       
+#define WINDOW  "_WINDOW"
 
 /*
- *  Message handlers.
+ *  Message handlers. Each of them returns whether it actually 
+ *  did something.
  */
-static void
+static Bool
 disableByMessage (Display* d, Window root)
 {
  /*
   *  The order in which things are done is rather important here.
   */
-  if (!secure)
-  {
-    setLockTrigger (lockTime);
-    disableKillTrigger ();
-    disabled = True;
-  }
+  if (secure) return False;
+
+  setLockTrigger (lockTime);
+  disableKillTrigger ();
+  disabled = True;
+  journal (jr_disable, 0);
+  return True;
 }
 
-static void
+static Bool
 enableByMessage (Display* d, Window root)
 {
-  if (!secure) 
-  {
-    resetTriggers ();
-    disabled = False;
-  }
+  if (secure) return False;
+
+  resetTriggers ();
+  disabled = False;
+  journal (jr_enable, 0);
+  return True;
 }
 
-static void
+static Bool
 toggleByMessage (Display* d, Window root)
 {
-  if (!secure)
+  if (secure) return False;
+
+  if ((disabled = !disabled)) /* = intended */
   {
-    if ((disabled = !disabled)) /* = intended */
-    {
-      setLockTrigger (lockTime);
-      disableKillTrigger ();
-    }
-    else
-    {
-      resetTriggers ();
-    }
+    setLockTrigger (lockTime);
+    disableKillTrigger ();
+    journal (jr_disable, 0);
   }
+  else
+  {
+    resetTriggers ();
+    journal (jr_enable, 0);
+  }
+
+  return True;
 }
 
-static void
+static Bool
 exitByMessage (Display* d, Window root)
 {
-  if (!secure)
+  if (secure) return False;
+
+ /*
+  *  When watching more than one display, only stop watching 
+  *  the one the message came from (see session.c).
+  */
+  if (displayList)
   {
-    error0 ("Exiting. Bye bye...\n");
-    exit (0);
+    return leave = True;
   }
+
+  error0 ("Exiting. Bye bye...\n");
+  exit (0);
+  /*NOTREACHED*/
 }
 
-static void
+static Bool
 lockNowByMessage (Display* d, Window root)
 {
-  if (!secure && !disabled) lockNow = True;
+  if (secure || disabled) return False;
+
+  if (!lockNow) lockRequested = preciseTime ();
+  return lockNow = True;
 }
 
-static void
+static Bool
 unlockNowByMessage (Display* d, Window root)
 {
-  if (!secure && !disabled) unlockNow = True;
+  if (secure || disabled) return False;
+
+  return unlockNow = True;
 }
 
-static void
+static Bool
 restartByMessage (Display* d, Window root)
 {
-  if (!secure)
-  {
-    XDeleteProperty (d, root, semaphore);
-    XFlush (d);
-    execv (argArray[0], argArray);
-  }
+  if (secure) return False;
+
+  releaseDisplay (d);
+  (void) execv (argArray[0], argArray);
+  return False;
+}
+
+static Bool
+reloadByMessage (Display* d, Window root)
+{
+  if (secure) return False;
+
+  return reloadSettings (d);
 }
 
 /*
- *  Function for looking for messages from another xautolock.
+ *  Function for no longer advertising ourselves on a display.
  */
 void
-lookForMessages (Display* d)
+releaseDisplay (Display* d)
 {
-  Window        root;         /* as it says              */
-  Atom          type;         /* actual property type    */
-  int           format;       /* dummy                   */
-  unsigned long nofItems;     /* dummy                   */
-  unsigned long after;        /* dummy                   */
-  int*          contents;     /* message property value  */
-  static Bool   first = True; /* is this the first call? */
+  Window root = RootWindowOfScreen (ScreenOfDisplay (d, 0));
 
- /*
-  *  It would be cleaner (more X-like, using less cpu time and
-  *  network bandwith, ...) to implement this functionality by
-  *  keeping an eye open for PropertyNotify events on the root
-  *  window, or (even better) by using ClientMessage events.
-  *  Maybe I'll rewrite it one day to do just that, but the
-  *  current approach works just fine too.
-  *
-  *  Note that we must clear the property before acting on it!
-  *  Otherwise funny things can happen on receipt of msg_exit.
-  */
-  root = RootWindowOfScreen (ScreenOfDisplay (d, 0));
+  XDeleteProperty (d, root, semaphore);
+  XDeleteProperty (d, root, windowAtom);
+  XFlush (d);
+  countRequests (xs_message, 2);
+}
 
-  (void) XGetWindowProperty (d, root, messageAtom, 0L, 2L, 
-                             False, AnyPropertyType, &type,
-			     &format, &nofItems, &after,
-			     (unsigned char**) &contents);
+/*
+ *  Function for acting on a message, no matter how it arrived.
+ *  Returns whether it was acted upon.
+ */
+Bool
+actOnMessage (Display* d, message msg)
+{
+  Window root = RootWindowOfScreen (ScreenOfDisplay (d, 0));
 
-  XDeleteProperty (d, root, messageAtom);
-  XFlush (d);
+  probe1 (message, (int) msg);
+
+  switch (msg)
+  {
+    case msg_disable:
+     return disableByMessage (d, root);
+
+    case msg_enable:
+     return enableByMessage (d, root);
+
+    case msg_toggle:
+     return toggleByMessage (d, root);
+
+    case msg_lockNow:
+     return lockNowByMessage (d, root);
+
+    case msg_unlockNow:
+     return unlockNowByMessage (d, root);
+
+    case msg_restart:
+     return restartByMessage (d, root);
+
+    case msg_reload:
+     return reloadByMessage (d, root);
+
+    case msg_exit:
+     return exitByMessage (d, root);
+
+    default:
+     /* unknown message, ignore silently */
+     return False;
+  }
+}
+
+/*
+ *  Function for picking up a message that an older xautolock left
+ *  in the message property on the root window. Reading and deleting
+ *  the property is done in one go, so that it is cleared before we
+ *  act on it. Otherwise funny things can happen on receipt of 
+ *  msg_exit.
+ */
+static void
+processLegacyMessage (Display* d, Window root)
+{
+  Atom           type;         /* actual property type   */
+  int            format;       /* property format        */
+  unsigned long  nofItems;     /* number of bytes        */
+  unsigned long  after;        /* dummy                  */
+  unsigned char* contents = 0; /* message property value */
+  message        msg;          /* as it says             */
+
+  (void) XGetWindowProperty (d, root, messageAtom, 0L, 2L, True,
+                             AnyPropertyType, &type, &format, 
+                             &nofItems, &after, &contents);
+  countRoundTrip (xs_message);
+
+  if (   type == XA_INTEGER
+      && format == 8
+      && nofItems == sizeof (msg))
+  {
+    (void) memcpy (&msg, contents, sizeof (msg));
+    (void) actOnMessage (d, msg);
+  }
+
+  if (contents) (void) XFree ((char*) contents);
+}
+
+/*
+ *  Function for acting on a message from another xautolock.
+ *  Returns whether the event actually was such a message.
+ */
+Bool
+processMessage (Display* d, XEvent* event)
+{
+  Window root = RootWindowOfScreen (ScreenOfDisplay (d, 0));
 
  /*
-  *  The very first time we get here, we ignore the message. Why?
-  *  Well, suppose some weirdo sends a SIGSTOP to a running xautolock,
-  *  then does an `xautolock -exit' and finally sends a SIGKILL to 
-  *  the stopped xautolock. This would leave an unread message sitting
-  *  around. Unread that is, till the next xautolock is started.
+  *  Messages used to be passed through a property on the root
+  *  window, which meant that we had to go and look for them every
+  *  second. Nowadays they arrive as ClientMessage events on the
+  *  window created by wmSetup(), so they cost nothing until one
+  *  actually gets sent.
   *
-  *  To solve this, we want any xautolock that enters the main event
-  *  loop to consume and ignore any message that may have been around
-  *  for a while and forgotten about.
+  *  For the benefit of older senders, which don't know about that
+  *  window, the property is still honoured for the time being. We 
+  *  get told about it through PropertyNotify, so it doesn't cost
+  *  any polling either.
   */
-  if (first)
-  {
-    first = False;
-  }
-  else if (type == XA_INTEGER)
+  if (   event->type == PropertyNotify
+      && event->xproperty.window == root
+      && event->xproperty.atom == messageAtom)
   {
-    switch (*contents)
+    if (event->xproperty.state == PropertyNewValue)
     {
-      case msg_disable:
-       disableByMessage (d, root);
-       break;
+      processLegacyMessage (d, root);
+    }
 
-      case msg_enable:
-       enableByMessage (d, root);
-       break;
+    return True;
+  }
 
-      case msg_toggle:
-       toggleByMessage (d, root);
-       break;
+  if (   event->type != ClientMessage
+      || event->xclient.message_type != messageAtom
+      || event->xclient.format != 32)
+  {
+    return False;
+  }
 
-      case msg_lockNow:
-       lockNowByMessage (d, root);
-       break;
+  (void) actOnMessage (d, (message) event->xclient.data.l[0]);
+  return True;
+}
 
-      case msg_unlockNow:
-       unlockNowByMessage (d, root);
-       break;
+/*
+ *  Function for sending a message to another xautolock. Returns
+ *  whether the message could be delivered to its window.
+ */
+static int
+catchSendFailure (Display* d, XErrorEvent* event)
+{
+  sendFailed = True;
+  return 0;
+}
 
-      case msg_restart:
-       restartByMessage (d, root);
-       break;
+static Bool
+sendMessage (Display* d, Window root)
+{
+  Atom          type;         /* actual property type  */
+  int           format;       /* dummy                 */
+  unsigned long nofItems;     /* number of windows     */
+  unsigned long after;        /* dummy                 */
+  Window*       contents = 0; /* window property value */
+  XEvent        event;        /* as it says            */
+  XErrorHandler previous;     /* as it says            */
+
+  (void) XGetWindowProperty (d, root, windowAtom, 0L, 1L, False,
+                             XA_WINDOW, &type, &format, &nofItems,
+                             &after, (unsigned char**) &contents);
+  countRoundTrip (xs_message);
+
+  if (type != XA_WINDOW || !nofItems)
+  {
+    if (contents) (void) XFree ((char*) contents);
+    return False;
+  }
 
-      case msg_exit:
-       exitByMessage (d, root);
-       break;
+  (void) memset (&event, 0, sizeof (event));
+  event.xclient.type = ClientMessage;
+  event.xclient.window = *contents;
+  event.xclient.message_type = messageAtom;
+  event.xclient.format = 32;
+  event.xclient.data.l[0] = (long) messageToSend;
 
-      default:
-       /* unknown message, ignore silently */
-       break;
-    }
-  }
+ /*
+  *  The window may be gone while the property is still around,
+  *  e.g. if the other xautolock got killed. That's not an error.
+  */
+  sendFailed = False;
+  previous = XSetErrorHandler (catchSendFailure);
+  (void) XSendEvent (d, *contents, False, NoEventMask, &event);
+  (void) XSync (d, 0);
+  countRequests (xs_message, 1);
+  countRoundTrip (xs_message);
+  (void) XSetErrorHandler (previous);
 
   (void) XFree ((char*) contents);
+  return !sendFailed;
 }
 
 /*
  *  Function for creating the communication atoms.
  */
+static Atom
+getAtom (Display* d, const char* suffix)
+{
+  Atom  atom; /* as it says     */
+  char* name; /* property name  */
+  char* ptr;  /* iterator       */
+
+  name = newArray (char, strlen (progName) + strlen (suffix) + 1);
+  (void) sprintf (name, "%s%s", progName, suffix);
+  for (ptr = name; *ptr; ++ptr) *ptr = (char) toupper (*ptr);
+  atom = XInternAtom (d, name, False);
+  countRoundTrip (xs_message);
+  free (name);
+
+  return atom;
+}
+
 void
 getAtoms (Display* d)
 {
-  char* sem; /* semaphore property name */
-  char* mes; /* message property name   */
-  char* ptr; /* iterator                */
-
-  sem = newArray (char, strlen (progName) + strlen (SEM_PID) + 1);
-  (void) sprintf (sem, "%s%s", progName, SEM_PID);
-  for (ptr = sem; *ptr; ++ptr) *ptr = (char) toupper (*ptr);
-  semaphore = XInternAtom (d, sem, False);
-  free (sem);
-
-  mes = newArray (char, strlen (progName) + strlen (MESSAGE) + 1);
-  (void) sprintf (mes, "%s%s", progName, MESSAGE);
-  for (ptr = mes; *ptr; ++ptr) *ptr = (char) toupper (*ptr);
-  messageAtom = XInternAtom (d, mes, False);
-  free (mes);
+  semaphore = getAtom (d, SEM_PID);
+  messageAtom = getAtom (d, MESSAGE);
+  windowAtom = getAtom (d, WINDOW);
+}
+
+/*
+ *  Atoms belong to a server, so in multi-display mode each display
+ *  needs its own set.
+ */
+void
+saveMessageState (messageState* s)
+{
+  s->semaphore = semaphore;
+  s->messageAtom = messageAtom;
+  s->windowAtom = windowAtom;
+}
+
+void
+loadMessageState (const messageState* s)
+{
+  semaphore = s->semaphore;
+  messageAtom = s->messageAtom;
+  windowAtom = s->windowAtom;
+}
+
+/*
+ *  Function for advertising ourselves on the root window.
+ */
+static void
+advertise (Display* d, Window root, Window ourWin)
+{
+  pid_t             pid = getpid (); /* as it says */
+  XWindowAttributes attrs;           /* as it says */
+
+  (void) XChangeProperty (d, root, semaphore, XA_INTEGER, 8, 
+                          PropModeReplace, (unsigned char*) &pid,
+			  (int) sizeof (pid));
+  (void) XChangeProperty (d, root, windowAtom, XA_WINDOW, 32, 
+                          PropModeReplace, (unsigned char*) &ourWin, 1);
+
+ /*
+  *  Get rid of any message that some older xautolock may have left
+  *  sitting around for a previous incarnation of ourselves.
+  */
+  XDeleteProperty (d, root, messageAtom);
+  countRequests (xs_message, 3);
+
+ /*
+  *  Keep listening to older senders (see processMessage()). This
+  *  must not clobber whatever else we've selected on the root.
+  */
+  if (XGetWindowAttributes (d, root, &attrs))
+  {
+    (void) XSelectInput (d, root, attrs.your_event_mask | LEGACY_MESSAGE_MASK);
+    countRequests (xs_message, 1);
+  }
+
+  countRoundTrip (xs_message);
+}
+
+/*
+ *  Function for taking charge of a display in multi-display mode.
+ *  Unlike checkConnectionAndSendMessage(), this doesn't give up on
+ *  everything if some other xautolock is already there, but merely
+ *  returns False. Our own process id doesn't count as some other
+ *  xautolock, as it is what we leave behind after -restart.
+ */
+Bool
+claimDisplay (Display* d, Window ourWin)
+{
+  Window        root;     /* as it says               */
+  Atom          type;     /* actual property type     */
+  int           format;   /* dummy                    */
+  unsigned long nofItems; /* dummy                    */
+  unsigned long after;    /* dummy                    */
+  pid_t*        contents; /* semaphore property value */
+  Bool          taken;    /* as it says               */
+
+  getAtoms (d);
+
+  root = RootWindowOfScreen (ScreenOfDisplay (d, 0));
+
+  (void) XGetWindowProperty (d, root, semaphore, 0L, 2L, False,
+                             AnyPropertyType, &type, &format,
+			     &nofItems, &after,
+                             (unsigned char**) &contents);
+  countRoundTrip (xs_message);
+
+  taken =    type == XA_INTEGER 
+          && *contents != getpid ()
+          && !kill (*contents, 0);
+
+  if (contents) (void) XFree ((char*) contents);
+  if (taken) return False;
+
+  advertise (d, root, ourWin);
+  return True;
 }
 
 /*
@@ -228,9 +461,8 @@ getAtoms (Display* d)
  *  wanted.
  */
 void
-checkConnectionAndSendMessage (Display* d)
+checkConnectionAndSendMessage (Display* d, Window ourWin)
 {
-  pid_t         pid;      /* as it says               */
   Window        root;     /* as it says               */
   Atom          type;     /* actual property type     */
   int           format;   /* dummy                    */
@@ -246,6 +478,7 @@ checkConnectionAndSendMessage (Display* d)
                              AnyPropertyType, &type, &format,
 			     &nofItems, &after,
                              (unsigned char**) &contents);
+  countRoundTrip (xs_message);
 
   if (type == XA_INTEGER)
   {
@@ -263,11 +496,32 @@ checkConnectionAndSendMessage (Display* d)
     }
     else if (messageToSend)
     {
-      (void) XChangeProperty (d, root, messageAtom, XA_INTEGER, 
-                              8, PropModeReplace, 
-			      (unsigned char*) &messageToSend, 
-			      (int) sizeof (messageToSend));
-      XFlush (d);
+     /*
+      *  Preferably, use the control socket, which tells us how things
+      *  went. Only that one knows how to answer a status request.
+      */
+      (void) sendControlMessage (d);
+
+      if (messageToSend == msg_status || messageToSend == msg_stats)
+      {
+        error1 ("Could not reach the control socket of %s.\n", progName);
+        exit (EXIT_FAILURE);
+      }
+
+     /*
+      *  Older versions of xautolock don't advertise a window to send 
+      *  the message to, but look for it in a property on the root 
+      *  window instead.
+      */
+      if (!sendMessage (d, root))
+      {
+        (void) XChangeProperty (d, root, messageAtom, XA_INTEGER, 
+                                8, PropModeReplace, 
+  			        (unsigned char*) &messageToSend, 
+			        (int) sizeof (messageToSend));
+        XFlush (d);
+      }
+
       exit (EXIT_SUCCESS);
     }
     else
@@ -286,10 +540,7 @@ checkConnectionAndSendMessage (Display* d)
     exit (EXIT_FAILURE);
   }
 
-  pid = getpid ();
-  (void) XChangeProperty (d, root, semaphore, XA_INTEGER, 8, 
-                          PropModeReplace, (unsigned char*) &pid,
-			  (int) sizeof (pid));
+  advertise (d, root, ourWin);
 
   (void) XFree ((char*) contents);
 }
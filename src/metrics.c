@@ -0,0 +1,389 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It implements
+ *          the stuff used for serving metrics to monitoring systems
+ *          (see -metrics).
+ *
+ *          The numbers are plain counters that get bumped wherever
+ *          things happen, so keeping them costs next to nothing. Only
+ *          when somebody asks do they get turned into text, in the
+ *          OpenMetrics format that Prometheus and friends understand.
+ *          The question can be asked on a Unix domain socket next to
+ *          the control socket (see control.c), with ".metrics" added
+ *          to its name, and, if so desired, on a TCP port of localhost.
+ *
+ *          Clients either send an HTTP GET request, in which case they
+ *          get an HTTP response, or a mere empty line (or just shut
+ *          down their end), in which case they get the bare text. The
+ *          connection is closed right after that.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#include "metrics.h"
+#include "control.h"
+#include "diy.h"
+#include "idlealarm.h"
+#include "options.h"
+#include "state.h"
+#include "miscutil.h"
+
+metricCounters metrics; /* as it says */
+
+#ifdef HasPoll
+
+#define MAX_LISTENERS  2
+#define MAX_CLIENTS    (MAX_METRICS_FDS - MAX_LISTENERS)
+#define REQUEST_SIZE   1024
+#define TEXT_SIZE      4096
+
+typedef struct
+{
+  int          fd;            /* -1 if not in use              */
+  unsigned     length;        /* bytes of the request so far   */
+  char         last;          /* last one of them, except \r   */
+  Bool         http;          /* whether it is an HTTP request */
+} aClient;
+
+static struct
+{
+  int                fds[MAX_LISTENERS];   /* listening sockets   */
+  struct sockaddr_un address;              /* of the Unix one     */
+  aClient            clients[MAX_CLIENTS]; /* as it says          */
+} server = { { -1, -1 } };
+
+static const char* subsystemNames[nofXSubsystems + 1] =
+{
+  "message", "engine", "diy"
+};
+
+static void
+removeSocket (void)
+{
+  (void) unlink (server.address.sun_path);
+}
+
+static int
+listenOn (int fd, struct sockaddr* address, socklen_t length)
+{
+  if (   fd < 0
+      || bind (fd, address, length)
+      || listen (fd, MAX_CLIENTS))
+  {
+    if (fd >= 0) (void) close (fd);
+    return -1;
+  }
+
+  (void) fcntl (fd, F_SETFD, FD_CLOEXEC);
+  (void) fcntl (fd, F_SETFL, O_NONBLOCK);
+  return fd;
+}
+
+#endif /* HasPoll */
+
+/*
+ *  Function for creating the sockets. Failing to do so isn't fatal,
+ *  we just do without.
+ */
+void
+initMetrics (Display* d)
+{
+#ifdef HasPoll
+  struct sockaddr_in address; /* as it says   */
+  mode_t             mask;    /* as it says   */
+  int                on = 1;  /* as it says   */
+  int                i;       /* loop counter */
+
+  for (i = 0; i < MAX_CLIENTS; ++i) server.clients[i].fd = -1;
+
+  if (!serveMetrics) return;
+
+  server.address.sun_family = AF_UNIX;
+
+  if (!runtimePath (d, ".metrics", server.address.sun_path,
+                    sizeof (server.address.sun_path)))
+  {
+    error0 ("No safe place for the metrics socket, not using it.\n");
+  }
+  else
+  {
+   /*
+    *  Same story as for the control socket.
+    */
+    (void) unlink (server.address.sun_path);
+    mask = umask (077);
+    server.fds[0] = listenOn (socket (AF_UNIX, SOCK_STREAM, 0),
+                              (struct sockaddr*) &server.address,
+                              sizeof (server.address));
+    (void) umask (mask);
+
+    if (server.fds[0] < 0)
+    {
+      error1 ("Couldn't set up the metrics socket %s.\n",
+              server.address.sun_path);
+    }
+    else
+    {
+      (void) atexit (removeSocket);
+    }
+  }
+
+  if (metricsPort)
+  {
+    (void) memset (&address, 0, sizeof (address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons ((unsigned short) metricsPort);
+    address.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+    if ((server.fds[1] = socket (AF_INET, SOCK_STREAM, 0)) >= 0)
+    {
+      (void) setsockopt (server.fds[1], SOL_SOCKET, SO_REUSEADDR,
+                         &on, sizeof (on));
+    }
+
+    server.fds[1] = listenOn (server.fds[1], (struct sockaddr*) &address,
+                              sizeof (address));
+
+    if (server.fds[1] < 0)
+    {
+      error1 ("Couldn't serve metrics on port %d.\n", metricsPort);
+    }
+  }
+#endif /* HasPoll */
+}
+
+#ifdef HasPoll
+
+/*
+ *  Function for telling the main loop what to wait for.
+ */
+int
+addMetricsFds (struct pollfd* fds)
+{
+  int nofFds = 0; /* as it says   */
+  int i;          /* loop counter */
+
+  for (i = 0; i < MAX_LISTENERS; ++i)
+  {
+    if (server.fds[i] >= 0)
+    {
+      fds[nofFds].fd = server.fds[i];
+      fds[nofFds++].events = POLLIN;
+    }
+  }
+
+  for (i = 0; i < MAX_CLIENTS; ++i)
+  {
+    if (server.clients[i].fd >= 0)
+    {
+      fds[nofFds].fd = server.clients[i].fd;
+      fds[nofFds++].events = POLLIN;
+    }
+  }
+
+  return nofFds;
+}
+
+/*
+ *  Function for putting the metrics into words. Returns the length.
+ */
+static int
+formatMetrics (char* text, size_t size)
+{
+  diyStats diy;                  /* as it says   */
+  int      length;               /* as it says   */
+  int      i;                    /* loop counter */
+
+  getDiyStats (&diy);
+
+  length = snprintf (text, size,
+                     "# TYPE xautolock_x_requests counter\n"
+                     "# HELP xautolock_x_requests X requests sent.\n");
+
+  for (i = 0; i <= nofXSubsystems; ++i)
+  {
+    length += snprintf (text + length, size - length,
+                        "xautolock_x_requests_total{subsystem=\"%s\"} %lu\n",
+                        subsystemNames[i],
+                        i < nofXSubsystems ? metrics.requests[i]
+                                           : diy.requests);
+  }
+
+  length += snprintf (text + length, size - length,
+                      "# TYPE xautolock_x_round_trips counter\n"
+                      "# HELP xautolock_x_round_trips X replies waited"
+                      " for.\n");
+
+  for (i = 0; i <= nofXSubsystems; ++i)
+  {
+    length += snprintf (text + length, size - length,
+                        "xautolock_x_round_trips_total{subsystem=\"%s\"}"
+                        " %lu\n", subsystemNames[i],
+                        i < nofXSubsystems ? metrics.roundTrips[i]
+                                           : diy.roundTrips);
+  }
+
+  length += snprintf (text + length, size - length,
+                      "# TYPE xautolock_wakeups counter\n"
+                      "xautolock_wakeups_total %lu\n"
+                      "# TYPE xautolock_diy_queue_depth gauge\n"
+                      "xautolock_diy_queue_depth %u\n"
+                      "# TYPE xautolock_x_errors counter\n"
+                      "# HELP xautolock_x_errors X errors ignored.\n"
+                      "xautolock_x_errors_total %lu\n"
+                      "# TYPE xautolock_locker_spawns counter\n"
+                      "xautolock_locker_spawns_total %lu\n"
+                      "# TYPE xautolock_locker_spawn_failures counter\n"
+                      "xautolock_locker_spawn_failures_total %lu\n"
+                      "# TYPE xautolock_locker_spawn_seconds summary\n"
+                      "# HELP xautolock_locker_spawn_seconds From deciding"
+                      " to lock to the locker running.\n"
+                      "xautolock_locker_spawn_seconds_count %lu\n"
+                      "xautolock_locker_spawn_seconds_sum %.6f\n"
+                      "# TYPE xautolock_idle_seconds gauge\n"
+                      "xautolock_idle_seconds %ld\n"
+                      "# EOF\n",
+                      metrics.wakeups, diy.queueDepth, xErrors,
+                      metrics.lockerSpawns, metrics.spawnFailures,
+                      metrics.lockerSpawns, metrics.spawnSeconds,
+                      (long) (currentTime () - lastActivity));
+
+  return length < (int) size ? length : (int) size - 1;
+}
+
+/*
+ *  Function for answering a client and getting rid of it. The answer
+ *  fits in the socket buffer of a fresh connection, so this doesn't
+ *  block. How idle the user is may take asking the server first.
+ */
+static void
+answer (Display* d, aClient* client)
+{
+  char header[160];     /* as it says */
+  char text[TEXT_SIZE]; /* as it says */
+  int  length;          /* as it says */
+
+  refreshIdleTime (d);
+  length = formatMetrics (text, sizeof (text));
+
+  if (client->http)
+  {
+    (void) sprintf (header,
+                    "HTTP/1.0 200 OK\r\n"
+                    "Content-Type: application/openmetrics-text;"
+                    " version=1.0.0; charset=utf-8\r\n"
+                    "Content-Length: %d\r\n\r\n", length);
+    (void) send (client->fd, header, strlen (header), MSG_NOSIGNAL);
+  }
+
+  (void) send (client->fd, text, (size_t) length, MSG_NOSIGNAL);
+  (void) close (client->fd);
+  client->fd = -1;
+}
+
+#endif /* HasPoll */
+
+/*
+ *  Function for dealing with whatever arrived on the sockets. Never
+ *  blocks.
+ */
+void
+processMetrics (Display* d)
+{
+#ifdef HasPoll
+  char     buffer[REQUEST_SIZE]; /* as it says         */
+  aClient* client;               /* as it says         */
+  ssize_t  got;                  /* bytes read         */
+  int      fd;                   /* new connection     */
+  int      i, j;                 /* loop counters      */
+
+  for (i = 0; i < MAX_LISTENERS; ++i)
+  {
+    if (server.fds[i] < 0) continue;
+
+    while ((fd = accept (server.fds[i], 0, 0)) >= 0) /* = intended */
+    {
+      for (j = 0; j < MAX_CLIENTS && server.clients[j].fd >= 0; ++j)
+      {
+        /* find a free slot */
+      }
+
+      if (j == MAX_CLIENTS)
+      {
+        (void) close (fd);
+        continue;
+      }
+
+      (void) fcntl (fd, F_SETFD, FD_CLOEXEC);
+      (void) fcntl (fd, F_SETFL, O_NONBLOCK);
+      (void) memset (&server.clients[j], 0, sizeof (aClient));
+      server.clients[j].fd = fd;
+    }
+  }
+
+ /*
+  *  All we care about in a request is how it starts and where it
+  *  ends: at the first empty line.
+  */
+  for (i = 0; i < MAX_CLIENTS; ++i)
+  {
+    client = &server.clients[i];
+
+    while (client->fd >= 0)
+    {
+      got = read (client->fd, buffer, sizeof (buffer));
+
+      if (got < 0 && (errno == EAGAIN || errno == EINTR)) break;
+
+      if (got < 0)
+      {
+        (void) close (client->fd);
+        client->fd = -1;
+        break;
+      }
+
+      if (got == 0)
+      {
+        answer (d, client);
+        break;
+      }
+
+      if (!client->length && got >= 4 && !strncmp (buffer, "GET ", 4))
+      {
+        client->http = True;
+      }
+
+      for (j = 0; j < got; ++j)
+      {
+        if (buffer[j] == '\r') continue;
+
+        if (buffer[j] == '\n' && (!client->length || client->last == '\n'))
+        {
+          break;
+        }
+
+        client->last = buffer[j];
+        ++client->length;
+      }
+
+      if (j < got)
+      {
+        answer (d, client);
+        break;
+      }
+    }
+  }
+#endif /* HasPoll */
+}
@@ -0,0 +1,514 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It implements
+ *          the stuff used for finding out which corner or other zone 
+ *          (if any) the pointer is in.
+ *
+ *          An X screen may well be spread across several monitors, in
+ *          which case most of its corners aren't where the user sees
+ *          them, or can't be reached at all. So if the server supports
+ *          version 1.3 or better of the RandR extension, we look at the
+ *          corners of each CRTC instead. A corner only counts if the
+ *          pointer can actually get stuck in it, i.e. if no other CRTC
+ *          continues where it ends.
+ *
+ *          Since the layout rarely changes, the areas making up the
+ *          corners and zones are worked out once and kept in a table,
+ *          which only gets rebuilt when the server says the layout has
+ *          changed (or when the settings do). The table comes with
+ *          a grid telling which of the areas overlap each cell of the 
+ *          screen, so that finding the one the pointer is in doesn't
+ *          depend on how many there are.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#include "monitors.h"
+#include "options.h"
+#include "miscutil.h"
+
+static monitorState table = {False, 0, False, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+/*
+ *  Function for adding an area to the table.
+ */
+static void
+addBox (int screen, int left, int top, int right, int bottom,
+        cornerAction action, time_t delay, time_t redelay)
+{
+  zoneBox* box; /* as it says */
+
+  if (action == ca_ignore || left > right || top > bottom) return;
+
+  if (table.nofBoxes == table.maxBoxes)
+  {
+    zoneBox* old = table.boxes; /* as it says */
+
+    table.maxBoxes = table.maxBoxes ? table.maxBoxes * 2 : 16;
+    table.boxes = newArray (zoneBox, table.maxBoxes);
+
+    if (old)
+    {
+      (void) memcpy (table.boxes, old, table.nofBoxes * sizeof (zoneBox));
+      free (old);
+    }
+  }
+
+  box = &table.boxes[table.nofBoxes++];
+  box->screen = screen;
+  box->left = left;
+  box->top = top;
+  box->right = right;
+  box->bottom = bottom;
+  box->action = action;
+  box->delay = delay;
+  box->redelay = redelay;
+}
+
+/*
+ *  Function for finding out whether a pixel is on any monitor other
+ *  than the given one.
+ */
+static Bool
+elsewhere (XRectangle* monitors, unsigned nofMonitors, unsigned self,
+           int x, int y)
+{
+  unsigned m; /* loop counter */
+
+  for (m = 0; m < nofMonitors; ++m)
+  {
+    if (   m != self
+        && x >= monitors[m].x && x < monitors[m].x + (int) monitors[m].width
+        && y >= monitors[m].y && y < monitors[m].y + (int) monitors[m].height)
+    {
+      return True;
+    }
+  }
+
+  return False;
+}
+
+/*
+ *  Function for adding the corners and zones of the monitors of a 
+ *  screen. Each corner is found by starting from its outermost pixel,
+ *  and moving inwards by `size' pixels in the direction given by dx
+ *  and dy. Zones are placed like X places windows, except that they
+ *  get cut off at the edges of the monitor. Where areas overlap, the
+ *  first one added wins.
+ */
+static void
+addMonitors (int screen, XRectangle* monitors, unsigned nofMonitors)
+{
+  static const int dx[4] = {1, -1, 1, -1};  /* inwards, per corner */
+  static const int dy[4] = {1, 1, -1, -1};  /* ditto               */
+  int              size = (int) cornerSize; /* as it says          */
+  unsigned         m;                       /* loop counter        */
+  int              c;                       /* loop counter        */
+  int              x;                       /* outermost pixel     */
+  int              y;                       /* ditto               */
+  int              w;                       /* as it says          */
+  int              h;                       /* as it says          */
+  unsigned         z;                       /* loop counter        */
+  const zone*      zn;                      /* as it says          */
+
+  for (m = 0; m < nofMonitors; ++m)
+  {
+    if (   table.smallest < 0
+        || MIN (monitors[m].width, monitors[m].height) < table.smallest)
+    {
+      table.smallest = MIN (monitors[m].width, monitors[m].height);
+    }
+
+    for (c = 0; c < 4; ++c)
+    {
+      x = dx[c] > 0 ? monitors[m].x
+                    : monitors[m].x + (int) monitors[m].width - 1;
+      y = dy[c] > 0 ? monitors[m].y
+                    : monitors[m].y + (int) monitors[m].height - 1;
+
+      if (   elsewhere (monitors, nofMonitors, m, x - dx[c], y)
+          || elsewhere (monitors, nofMonitors, m, x, y - dy[c]))
+      {
+        continue;
+      }
+
+      addBox (screen, MIN (x, x + dx[c] * size), MIN (y, y + dy[c] * size),
+                      MAX (x, x + dx[c] * size), MAX (y, y + dy[c] * size),
+              corners[c], cornerDelay, cornerRedelay);
+    }
+
+    for (z = 0; z < nofZones; ++z)
+    {
+      zn = &zones[z];
+      w = zn->mask & WidthValue  ? (int) zn->width  : monitors[m].width;
+      h = zn->mask & HeightValue ? (int) zn->height : monitors[m].height;
+      x = zn->mask & XNegative ? monitors[m].width + zn->x - w : zn->x;
+      y = zn->mask & YNegative ? monitors[m].height + zn->y - h : zn->y;
+
+      addBox (screen, 
+              monitors[m].x + MAX (x, 0),
+              monitors[m].y + MAX (y, 0),
+              monitors[m].x + MIN (x + w, (int) monitors[m].width) - 1,
+              monitors[m].y + MIN (y + h, (int) monitors[m].height) - 1,
+              zn->action, zn->delay, zn->redelay);
+    }
+  }
+}
+
+#ifdef HasXrandr
+/*
+ *  Function for asking the server where the CRTCs of a screen are.
+ *  Returns how many of them are in use, and stores their positions
+ *  in a freshly allocated array.
+ */
+static unsigned
+queryCrtcs (Display* d, int screen, XRectangle** monitors)
+{
+  XRRScreenResources* resources; /* as it says   */
+  XRRCrtcInfo*        info;      /* as it says   */
+  unsigned            n = 0;     /* as it says   */
+  int                 c;         /* loop counter */
+
+  if (!(resources = XRRGetScreenResourcesCurrent (d, RootWindow (d, screen))))
+  {
+    return 0;
+  }
+
+  *monitors = newArray (XRectangle, resources->ncrtc + 1);
+
+  for (c = 0; c < resources->ncrtc; ++c)
+  {
+    if (!(info = XRRGetCrtcInfo (d, resources, resources->crtcs[c])))
+    {
+      continue;
+    }
+
+    if (info->mode != None && info->width && info->height)
+    {
+      (*monitors)[n].x = info->x;
+      (*monitors)[n].y = info->y;
+      (*monitors)[n].width = info->width;
+      (*monitors)[n].height = info->height;
+      ++n;
+    }
+
+    XRRFreeCrtcInfo (info);
+  }
+
+  XRRFreeScreenResources (resources);
+
+  if (!n)
+  {
+    free (*monitors);
+    *monitors = 0;
+  }
+
+  return n;
+}
+#endif /* HasXrandr */
+
+/*
+ *  Function for working out which grid cells (if any) an area covers.
+ */
+static Bool
+boxCells (const zoneBox* box, const screenGrid* grid,
+          int* left, int* top, int* right, int* bottom)
+{
+  if (   box->right < 0 || box->left >= grid->width
+      || box->bottom < 0 || box->top >= grid->height)
+  {
+    return False;
+  }
+
+  *left = MAX (box->left, 0) / GRID_CELL;
+  *top = MAX (box->top, 0) / GRID_CELL;
+  *right = MIN (box->right, grid->width - 1) / GRID_CELL;
+  *bottom = MIN (box->bottom, grid->height - 1) / GRID_CELL;
+
+  return True;
+}
+
+/*
+ *  Function for (re)building the grid. The boxes of each cell end up
+ *  next to each other in cellBoxes, in the order they were added, with
+ *  cells telling where they start. First count them, then turn the
+ *  counts into where each cell ends, and then fill the cells backwards.
+ */
+static void
+buildGrid (Display* d)
+{
+  unsigned    nofCells = 0; /* as it says   */
+  unsigned    total = 0;    /* as it says   */
+  screenGrid* grid;         /* as it says   */
+  int         s;            /* loop counter */
+  unsigned    b;            /* loop counter */
+  unsigned    c;            /* loop counter */
+  int         left, top, right, bottom; /* cells covered */
+  int         x, y;                     /* loop counters */
+
+  if (table.grids) free (table.grids);
+  if (table.cells) free (table.cells);
+  if (table.cellBoxes) free (table.cellBoxes);
+
+  table.grids = newArray (screenGrid, ScreenCount (d));
+
+  for (s = -1; ++s < ScreenCount (d); )
+  {
+    grid = &table.grids[s];
+    grid->width = WidthOfScreen (ScreenOfDisplay (d, s));
+    grid->height = HeightOfScreen (ScreenOfDisplay (d, s));
+    grid->columns = (grid->width + GRID_CELL - 1) / GRID_CELL;
+    grid->rows = (grid->height + GRID_CELL - 1) / GRID_CELL;
+    grid->first = nofCells;
+    nofCells += grid->columns * grid->rows;
+  }
+
+  table.cells = newArray (unsigned, nofCells + 1);
+  (void) memset (table.cells, 0, (nofCells + 1) * sizeof (unsigned));
+
+  for (b = 0; b < table.nofBoxes; ++b)
+  {
+    grid = &table.grids[table.boxes[b].screen];
+
+    if (!boxCells (&table.boxes[b], grid, &left, &top, &right, &bottom))
+    {
+      continue;
+    }
+
+    for (y = top; y <= bottom; ++y)
+    {
+      for (x = left; x <= right; ++x)
+      {
+        ++table.cells[grid->first + y * grid->columns + x];
+      }
+    }
+  }
+
+  for (c = 0; c <= nofCells; ++c)
+  {
+    total += table.cells[c];
+    table.cells[c] = total;
+  }
+
+  table.cellBoxes = newArray (unsigned, total + 1);
+
+  for (b = table.nofBoxes; b-- > 0; )
+  {
+    grid = &table.grids[table.boxes[b].screen];
+
+    if (!boxCells (&table.boxes[b], grid, &left, &top, &right, &bottom))
+    {
+      continue;
+    }
+
+    for (y = top; y <= bottom; ++y)
+    {
+      for (x = left; x <= right; ++x)
+      {
+        table.cellBoxes[--table.cells[grid->first + y * grid->columns + x]]
+          = b;
+      }
+    }
+  }
+}
+
+/*
+ *  Function for (re)building the table. Screens we don't know any
+ *  better about count as a single monitor.
+ */
+static void
+buildTable (Display* d)
+{
+  XRectangle* monitors;     /* as it says   */
+  XRectangle  whole;        /* as it says   */
+  unsigned    nofMonitors;  /* as it says   */
+  int         s;            /* loop counter */
+
+  table.nofBoxes = 0;
+  table.smallest = -1;
+
+  for (s = -1; ++s < ScreenCount (d); )
+  {
+    monitors = 0;
+    nofMonitors = 0;
+
+#ifdef HasXrandr
+    if (table.useRandr) nofMonitors = queryCrtcs (d, s, &monitors);
+#endif /* HasXrandr */
+
+    if (nofMonitors)
+    {
+      addMonitors (s, monitors, nofMonitors);
+      free (monitors);
+    }
+    else
+    {
+      whole.x = whole.y = 0;
+      whole.width = WidthOfScreen (ScreenOfDisplay (d, s));
+      whole.height = HeightOfScreen (ScreenOfDisplay (d, s));
+      addMonitors (s, &whole, 1);
+    }
+  }
+
+  buildGrid (d);
+  table.built = True;
+  table.builtSize = cornerSize;
+  table.reloaded = reloads;
+}
+
+/*
+ *  Function for finding out which corner or zone (if any) a position
+ *  is in. Returns whether there is one, and if so, what it is.
+ *
+ *  On initial server startup, if (and only if) the pointer is never
+ *  moved, XQueryPointer() can return values less than zero (only 
+ *  some servers, Openwindows 2.0 and 3.0 in particular). Since no
+ *  monitor starts left of or above zero, those never end up in a 
+ *  corner.
+ */
+Bool
+whichZone (Display* d, Screen* screen, int rootX, int rootY, zoneBox* found)
+{
+  int         s = XScreenNumberOfScreen (screen); /* as it says   */
+  screenGrid* grid;                               /* as it says   */
+  zoneBox*    box;                                /* as it says   */
+  unsigned    cell;                               /* as it says   */
+  unsigned    b;                                  /* loop counter */
+
+  if (   !table.built
+      || table.builtSize != cornerSize
+      || table.reloaded != reloads)
+  {
+    buildTable (d);
+  }
+
+  grid = &table.grids[s];
+
+  if (   rootX < 0 || rootX >= grid->width
+      || rootY < 0 || rootY >= grid->height)
+  {
+    return False;
+  }
+
+  cell = grid->first + rootY / GRID_CELL * grid->columns + rootX / GRID_CELL;
+
+  for (b = table.cells[cell]; b < table.cells[cell + 1]; ++b)
+  {
+    box = &table.boxes[table.cellBoxes[b]];
+
+    if (   rootX >= box->left && rootX <= box->right
+        && rootY >= box->top  && rootY <= box->bottom)
+    {
+      *found = *box;
+      return True;
+    }
+  }
+
+  return False;
+}
+
+/*
+ *  Function for finding out how small the smallest monitor is, which
+ *  limits how big the corners can be.
+ */
+int
+smallestMonitor (Display* d)
+{
+  if (!table.built) buildTable (d);
+  return table.smallest;
+}
+
+/*
+ *  Function for noticing that the layout changed. Returns whether
+ *  the event was one of ours.
+ */
+Bool
+processMonitorEvent (XEvent* event)
+{
+#ifdef HasXrandr
+  if (   table.useRandr
+      && (   event->type == table.eventBase + RRScreenChangeNotify
+          || event->type == table.eventBase + RRNotify))
+  {
+    (void) XRRUpdateConfiguration (event);
+    table.built = False;
+    return True;
+  }
+#endif /* HasXrandr */
+
+  return False;
+}
+
+/*
+ *  Function for initialising the whole shebang. Besides the size of
+ *  the screen, a layout change may also just move a CRTC around.
+ */
+void
+initMonitors (Display* d)
+{
+#ifdef HasXrandr
+  int dummy;     /* as it says    */
+  int major = 0; /* as it says    */
+  int minor = 0; /* as it says    */
+  int s;         /* screen number */
+#endif /* HasXrandr */
+
+  table.useRandr = False;
+  table.built = False;
+
+#ifdef HasXrandr
+  if (   XRRQueryExtension (d, &table.eventBase, &dummy)
+      && XRRQueryVersion (d, &major, &minor)
+      && (major > 1 || (major == 1 && minor >= 3)))
+  {
+    table.useRandr = True;
+
+    for (s = -1; ++s < ScreenCount (d); )
+    {
+      XRRSelectInput (d, RootWindow (d, s),
+                      RRScreenChangeNotifyMask | RRCrtcChangeNotifyMask);
+    }
+  }
+#endif /* HasXrandr */
+}
+
+/*
+ *  Functions for multi-display mode (see session.c).
+ */
+void
+saveMonitorState (monitorState* s)
+{
+  *s = table;
+}
+
+void
+loadMonitorState (const monitorState* s)
+{
+  table = *s;
+}
+
+void
+freeMonitorState (monitorState* s)
+{
+  if (s->boxes) free (s->boxes);
+  if (s->grids) free (s->grids);
+  if (s->cells) free (s->cells);
+  if (s->cellBoxes) free (s->cellBoxes);
+  s->boxes = 0;
+  s->grids = 0;
+  s->cells = s->cellBoxes = 0;
+  s->nofBoxes = s->maxBoxes = 0;
+  s->built = False;
+}
@@ -20,6 +20,7 @@
 
 #include "options.h"
 #include "state.h"
+#include "monitors.h"
 #include "miscutil.h"
 #include "version.h"
 
@@ -43,6 +44,9 @@ Bool         notifyLock = False;         /* whether to notify the user
 Bool         useRedelay = False;         /* as it says                  */
 cornerAction corners[4] = { ca_ignore, ca_ignore, ca_ignore, ca_ignore };
                                          /* default cornerActions       */
+zone*        zones = 0;                  /* other areas acting like
+                                            corners                     */
+unsigned     nofZones = 0;               /* as it says                  */
 Bool         resetSaver = False;         /* whether to reset the X 
 				            screensaver                 */
 Bool         noCloseOut = False;         /* whether keep stdout open    */
@@ -52,6 +56,32 @@ message      messageToSend = msg_none;   /* message to send to an
 Bool         detectSleep = False;        /* whether to reset the timers
 					    after a (laptop) sleep, 
 					    i.e. after a big time jump  */
+Bool         tickless = False;           /* whether to sleep until the
+                                            next trigger instead of
+                                            waking up every second      */
+Bool         forceDiy = False;           /* whether to ignore all server
+                                            extensions for detecting
+                                            user activity               */
+Bool         noShell = False;            /* whether to avoid running
+                                            commands through a shell    */
+Bool         warmLocker = False;         /* whether to keep a locker
+                                            process ready to go         */
+Bool         writeStatus = False;        /* whether to keep a status
+                                            page for others to read     */
+const char*  displayList = 0;            /* displays to watch, or 0 for
+                                            just the one we're on       */
+const char*  journalFile = 0;            /* where to keep a journal, or
+                                            0 for not keeping one       */
+Bool         serveMetrics = False;       /* whether to serve metrics    */
+int          metricsPort = 0;            /* TCP port to serve them on,
+                                            or 0 for none               */
+char**       lockerArgv = 0;             /* pre-parsed locker, or 0 if
+                                            it needs a shell            */
+char**       nowLockerArgv = 0;          /* same for the nowlocker      */
+char**       notifierArgv = 0;           /* same for the notifier       */
+char**       killerArgv = 0;             /* same for the killer         */
+unsigned     reloads = 0;                /* times the settings got
+                                            reloaded (see -reload)      */
 
 #ifdef VMS
 struct dsc$descriptor lockerDescr;       /* used to fire up the locker  */
@@ -70,6 +100,46 @@ static Bool redelaySpecified = False;
 static Bool bellSpecified = False;
 static Bool dummySpecified;
 
+/*
+ *  Everything that -reload may change (see the option table below),
+ *  so that it can be put back when the new settings don't work out.
+ */
+typedef struct
+{
+  const char*  locker;
+  const char*  nowLocker;
+  const char*  notifier;
+  const char*  killer;
+  time_t       lockTime;
+  time_t       killTime;
+  time_t       notifyMargin;
+  time_t       cornerDelay;
+  time_t       cornerRedelay;
+  int          bellPercent;
+  unsigned     cornerSize;
+  Bool         notifyLock;
+  Bool         resetSaver;
+  cornerAction corners[4];
+  zone*        zones;
+  unsigned     nofZones;
+  char**       lockerArgv;
+  char**       nowLockerArgv;
+  char**       notifierArgv;
+  char**       killerArgv;
+#ifdef VMS
+  struct dsc$descriptor lockerDescr;
+  struct dsc$descriptor nowLockerDescr;
+#endif /* VMS */
+  Bool         notifierSpecified;
+  Bool         killerSpecified;
+  Bool         killTimeSpecified;
+  Bool         redelaySpecified;
+  Bool         bellSpecified;
+} settings;
+
+static settings    defaults;                    /* before any options  */
+static XrmDatabase reloadedDbs[2] = { 0, 0 };   /* see reloadOpts ()   */
+
 static void usage (int exitCode);
 
 /*
@@ -136,6 +206,26 @@ notifierAction (Display* d, const char* arg)
   return True;
 }
 
+static Bool
+displaysAction (Display* d, const char* arg)
+{
+  displayList = arg;
+  return True;
+}
+
+static Bool
+journalAction (Display* d, const char* arg)
+{
+  journalFile = arg;
+  return True;
+}
+
+static Bool
+metricsPortAction (Display* d, const char* arg)
+{
+  return getPositive (arg, &metricsPort);
+}
+
 static Bool
 bellAction (Display* d, const char* arg)
 {
@@ -178,6 +268,84 @@ cornersAction (Display* d, const char* arg)
   return True;
 }
 
+/*
+ *  Zones look like "+200x40-0+0/5": what to do, as for the corners,
+ *  where (as for the -geometry option, relative to each monitor, and
+ *  with a missing width or height meaning all of it), and possibly 
+ *  how many seconds to wait before locking. 
+ */
+static Bool
+zonesAction (Display* d, const char* arg)
+{
+  char*    copy = strdup (arg); /* as it says          */
+  char*    spec;                /* one zone            */
+  char*    delay;               /* its delay, if any   */
+  zone*    z;                   /* as it says          */
+  int      tmp;                 /* as it says          */
+  Bool     retVal = True;       /* as it says          */
+  unsigned maxZones = 0;        /* room in zones       */
+
+  if (zones) free (zones);
+  zones = 0;
+  nofZones = 0;
+
+  for (spec = strtok (copy, ", \t\n"); spec; spec = strtok (0, ", \t\n"))
+  {
+    if (nofZones == maxZones)
+    {
+      zone* old = zones; /* as it says */
+
+      maxZones = maxZones ? maxZones * 2 : 8;
+      zones = newArray (zone, maxZones);
+
+      if (old)
+      {
+        (void) memcpy (zones, old, nofZones * sizeof (zone));
+        free (old);
+      }
+    }
+
+    z = &zones[nofZones];
+
+    switch (*spec)
+    {
+      case '-': z->action = ca_dontLock;  break;
+      case '+': z->action = ca_forceLock; break;
+      default:  retVal = False;           continue;
+    }
+
+    z->delay = z->redelay = -1;
+
+    if ((delay = strchr (spec, '/'))) /* = intended */
+    {
+      *delay++ = '\0';
+
+      if (!getPositive (delay, &tmp))
+      {
+        retVal = False;
+        continue;
+      }
+
+      z->delay = tmp;
+    }
+
+    z->mask = XParseGeometry (spec + 1, &z->x, &z->y, &z->width, &z->height);
+
+    if (   !z->mask
+        || ((z->mask & WidthValue) && !z->width)
+        || ((z->mask & HeightValue) && !z->height))
+    {
+      retVal = False;
+      continue;
+    }
+
+    ++nofZones;
+  }
+
+  free (copy);
+  return retVal;
+}
+
 #define TIME_ACTION(name,nameSpecified)                    \
 static Bool                                                \
 name##Action (Display* d, const char* arg)                 \
@@ -216,8 +384,11 @@ MESSAGE_ACTION (enable   )
 MESSAGE_ACTION (toggle   )
 MESSAGE_ACTION (exit     )
 MESSAGE_ACTION (lockNow  )
+MESSAGE_ACTION (status   )
+MESSAGE_ACTION (stats    )
 MESSAGE_ACTION (unlockNow)
 MESSAGE_ACTION (restart  )
+MESSAGE_ACTION (reload   )
 
 #define BOOL_ACTION(name)                  \
 static Bool                                \
@@ -231,6 +402,12 @@ BOOL_ACTION (resetSaver)
 BOOL_ACTION (noCloseOut)
 BOOL_ACTION (noCloseErr)
 BOOL_ACTION (detectSleep)
+BOOL_ACTION (tickless   )
+BOOL_ACTION (forceDiy   )
+BOOL_ACTION (noShell    )
+BOOL_ACTION (warmLocker )
+BOOL_ACTION (writeStatus)
+BOOL_ACTION (serveMetrics)
 
 static Bool
 noCloseAction (Display* d, const char* arg)
@@ -263,6 +440,84 @@ addExecToCommand (const char** command)
     *command = tmp;
   }
 }
+
+#ifdef HasPosixSpawn
+/*
+ *  Split a command into its arguments, the way the shell would. This
+ *  only deals with plain words and quoting. Anything beyond that (and
+ *  that's the kind of thing people will use a shell for) gets us to 
+ *  return 0, meaning that we do need a shell after all.
+ */
+static char**
+splitCommand (const char* command)
+{
+  char**      argv;                /* as it says                 */
+  char*       buffer;              /* holds all of the arguments */
+  char*       to;                  /* where the next char goes   */
+  const char* from;                /* iterator                   */
+  unsigned    argc = 0;            /* number of arguments        */
+  char        quote = '\0';        /* current quote, if any      */
+  Bool        inWord = False;      /* as it says                 */
+
+  argv = newArray (char*, strlen (command) / 2 + 2);
+  to = buffer = newArray (char, strlen (command) + 1);
+
+  for (from = command; *from; ++from)
+  {
+    if (!quote && (*from == ' ' || *from == '\t'))
+    {
+      if (inWord) *to++ = '\0';
+      inWord = False;
+      continue;
+    }
+
+    if (!inWord)
+    {
+      argv[argc++] = to;
+      inWord = True;
+    }
+
+    if (quote == '\'')
+    {
+      if (*from == '\'') quote = '\0';
+      else               *to++ = *from;
+    }
+    else if (quote == '"')
+    {
+      if (strchr ("$`\\", *from)) break;
+
+      if (*from == '"') quote = '\0';
+      else              *to++ = *from;
+    }
+    else if (   strchr ("|&;<>()$`\\*?[]{}\n", *from)
+             || (strchr ("#~", *from) && to == argv[argc - 1])
+             || (*from == '=' && argc == 1))
+    {
+      break;
+    }
+    else if (*from == '\'' || *from == '"')
+    {
+      quote = *from;
+    }
+    else
+    {
+      *to++ = *from;
+    }
+  }
+
+  *to = '\0';
+  argv[argc] = 0;
+
+  if (*from || quote || !argc)
+  {
+    free (buffer);
+    free (argv);
+    return 0;
+  }
+
+  return argv;
+}
+#endif /* HasPosixSpawn */
 #endif /* !VMS */
 
 static void 
@@ -309,6 +564,9 @@ static void
 lockerChecker (Display* d)
 {
 #ifndef VMS
+#ifdef HasPosixSpawn
+  if (noShell) lockerArgv = splitCommand (locker);
+#endif /* HasPosixSpawn */
   addExecToCommand (&locker);
 #else /* VMS */
  /*
@@ -325,6 +583,9 @@ static void
 nowLockerChecker (Display* d)
 {
 #ifndef VMS
+#ifdef HasPosixSpawn
+  if (noShell) nowLockerArgv = splitCommand (nowLocker);
+#endif /* HasPosixSpawn */
   addExecToCommand (&nowLocker);
 #else /* VMS */
  /*
@@ -355,6 +616,9 @@ notifierChecker (Display* d)
       *  later. The rationale behind this hack is explained elsewhere.
       */
       char* tmp;
+#ifdef HasPosixSpawn
+      if (noShell) notifierArgv = splitCommand (notifier);
+#endif /* HasPosixSpawn */
       (void) sprintf (tmp = newArray (char, strlen (notifier) + 3),
 		      "%s &", notifier);
       notifier = tmp;
@@ -375,6 +639,9 @@ killerChecker (Display* d)
     *  later. The rationale behind this hack is explained elsewhere.
     */
     char* tmp;
+#ifdef HasPosixSpawn
+    if (noShell) killerArgv = splitCommand (killer);
+#endif /* HasPosixSpawn */
     (void) sprintf (tmp = newArray (char, strlen (killer) + 3),
 		    "%s &", killer);
     killer = tmp;
@@ -435,26 +702,137 @@ bellChecker (Display* d)
 static void
 cornerSizeChecker (Display* d)
 {
-  int      s;
-  Screen*  scr;
-  int      maxCornerSize;
+  int      smallest = smallestMonitor (d); /* as it says    */
+  int      s;                              /* screen number */
+  Screen*  scr;                            /* as it says    */
 
-  for (maxCornerSize = 32000, s = -1; ++s < ScreenCount (d); )
+ /*
+  *  Without any monitors to go by, the screens will have to do.
+  */
+  if (smallest < 0)
   {
-    scr = ScreenOfDisplay (d, s);
-
-    if (   maxCornerSize > WidthOfScreen (scr)  / 4
-        || maxCornerSize > HeightOfScreen (scr) / 4)
+    for (s = -1; ++s < ScreenCount (d); )
     {
-      maxCornerSize = MIN (WidthOfScreen (scr), HeightOfScreen (scr)) / 4;
+      scr = ScreenOfDisplay (d, s);
+
+      if (   smallest < 0 
+          || MIN (WidthOfScreen (scr), HeightOfScreen (scr)) < smallest)
+      {
+        smallest = MIN (WidthOfScreen (scr), HeightOfScreen (scr));
+      }
     }
   }
 
-  if (cornerSize > maxCornerSize)
+  if (smallest >= 0 && cornerSize > (unsigned) smallest / 4)
+  {
+    error1 ("Corner size reset to %u pixels.\n",
+            cornerSize = (unsigned) smallest / 4);
+  }
+}
+
+static void
+ticklessChecker (Display* d)
+{
+#ifndef HasPoll
+  if (tickless)
+  {
+    error0 ("No support for -tickless compiled in, ignoring it.\n");
+    tickless = False;
+  }
+#endif /* HasPoll */
+}
+
+static void
+noShellChecker (Display* d)
+{
+#ifndef HasPosixSpawn
+  if (noShell)
+  {
+    error0 ("No support for -noshell compiled in, ignoring it.\n");
+    noShell = False;
+  }
+#endif /* HasPosixSpawn */
+}
+
+static void
+warmLockerChecker (Display* d)
+{
+#ifdef VMS
+  if (warmLocker)
+  {
+    error0 ("No support for -warmlocker on VMS, ignoring it.\n");
+    warmLocker = False;
+  }
+#endif /* VMS */
+}
+
+static void
+writeStatusChecker (Display* d)
+{
+#ifndef HasMmap
+  if (writeStatus)
+  {
+    error0 ("No support for -statuspage compiled in, ignoring it.\n");
+    writeStatus = False;
+  }
+#endif /* HasMmap */
+}
+
+static void
+journalChecker (Display* d)
+{
+#ifdef VMS
+  if (journalFile)
+  {
+    error0 ("No support for -journal on VMS, ignoring it.\n");
+    journalFile = 0;
+  }
+#endif /* VMS */
+}
+
+static void
+metricsChecker (Display* d)
+{
+  if (metricsPort > 65535)
+  {
+    error0 ("Metrics port out of range, ignoring it.\n");
+    metricsPort = 0;
+  }
+
+  if (metricsPort) serveMetrics = True;
+
+#ifndef HasPoll
+  if (serveMetrics)
+  {
+    error0 ("No support for -metrics compiled in, ignoring it.\n");
+    serveMetrics = False;
+  }
+#endif /* HasPoll */
+}
+
+static void
+displaysChecker (Display* d)
+{
+  if (!displayList) return;
+
+#if defined (VMS) || !defined (HasPoll) \
+    || (!defined (HasScreenSaver) && !defined (HasXidle))
+  error0 ("No support for -displays compiled in, ignoring it.\n");
+  displayList = 0;
+#else /* VMS || !HasPoll || (!HasScreenSaver && !HasXidle) */
+  if (warmLocker)
+  {
+    error0 ("-warmlocker does not go with -displays, ignoring it.\n");
+    warmLocker = False;
+  }
+
+  if (serveMetrics)
   {
-    error1 ("Corner size reset to %d pixels.\n",
-            cornerSize = maxCornerSize);
+    error0 ("-metrics does not go with -displays, ignoring it.\n");
+    serveMetrics = False;
+    metricsPort = 0;
   }
+#endif /* VMS || !HasPoll || (!HasScreenSaver && !HasXidle) */
 }
 
 static void
@@ -466,6 +844,25 @@ cornerReDelayChecker (Display* d)
   }
 }
 
+static void
+zonesChecker (Display* d)
+{
+  unsigned z; /* loop counter */
+
+  for (z = 0; z < nofZones; ++z)
+  {
+    if (zones[z].delay < 0)
+    {
+      zones[z].delay = cornerDelay;
+      zones[z].redelay = cornerRedelay;
+    }
+    else
+    {
+      zones[z].redelay = redelaySpecified ? cornerRedelay : zones[z].delay;
+    }
+  }
+}
+
 /*
  *  The central option table.
  */
@@ -479,62 +876,89 @@ static struct
   caddr_t       value;   /* only for XrmOptionNoArg */
   optAction     action;  /* as it says              */
   optChecker    checker; /* as it says              */
+  Bool          reload;  /* whether -reload applies  */
 } options[] = 
 {
   {"help"              , XrmoptionNoArg , (caddr_t) "",
-    helpAction         , (optChecker) 0            },
+    helpAction         , (optChecker) 0       , False },
   {"version"           , XrmoptionNoArg , (caddr_t) "",
-    versionAction      , (optChecker) 0            },
+    versionAction      , (optChecker) 0       , False },
   {"locker"            , XrmoptionSepArg, (caddr_t) 0 ,
-    lockerAction       , lockerChecker             },
+    lockerAction       , lockerChecker        , True  },
   {"nowlocker"         , XrmoptionSepArg, (caddr_t) 0 ,
-    nowLockerAction    , nowLockerChecker          },
+    nowLockerAction    , nowLockerChecker     , True  },
   {"killer"            , XrmoptionSepArg, (caddr_t) 0 ,
-    killerAction       , killerChecker             },
+    killerAction       , killerChecker        , True  },
   {"notifier"          , XrmoptionSepArg, (caddr_t) 0 ,
-    notifierAction     , notifierChecker           },
+    notifierAction     , notifierChecker      , True  },
   {"corners"           , XrmoptionSepArg, (caddr_t) 0 ,
-    cornersAction      , (optChecker) 0            },
+    cornersAction      , (optChecker) 0       , True  },
   {"cornersize"        , XrmoptionSepArg, (caddr_t) 0 ,
-    cornerSizeAction   , cornerSizeChecker         },
+    cornerSizeAction   , cornerSizeChecker    , True  },
   {"cornerdelay"       , XrmoptionSepArg, (caddr_t) 0 ,
-    cornerDelayAction  , (optChecker) 0            },
+    cornerDelayAction  , (optChecker) 0       , True  },
   {"cornerredelay"     , XrmoptionSepArg, (caddr_t) 0 ,
-    cornerRedelayAction, cornerReDelayChecker      },
+    cornerRedelayAction, cornerReDelayChecker , True  },
+  {"zones"             , XrmoptionSepArg, (caddr_t) 0 ,
+    zonesAction        , zonesChecker         , True  },
   {"killtime"          , XrmoptionSepArg, (caddr_t) 0 ,
-    killTimeAction     , killTimeChecker           },
+    killTimeAction     , killTimeChecker      , True  },
   {"time"              , XrmoptionSepArg, (caddr_t) 0 ,
-    lockTimeAction     , lockTimeChecker           },
+    lockTimeAction     , lockTimeChecker      , True  },
   {"notify"            , XrmoptionSepArg, (caddr_t) 0 ,
-    notifyAction       , notifyChecker             },
+    notifyAction       , notifyChecker        , True  },
   {"bell"              , XrmoptionSepArg, (caddr_t) 0 ,
-    bellAction         , bellChecker               },
+    bellAction         , bellChecker          , True  },
   {"secure"            , XrmoptionNoArg , (caddr_t) "",
-    secureAction       , (optChecker) 0            },
+    secureAction       , (optChecker) 0       , False },
   {"enable"            , XrmoptionNoArg , (caddr_t) "",
-    enableAction       , (optChecker) 0            },
+    enableAction       , (optChecker) 0       , False },
   {"disable"           , XrmoptionNoArg , (caddr_t) "",
-    disableAction      , (optChecker) 0            },
+    disableAction      , (optChecker) 0       , False },
   {"toggle"            , XrmoptionNoArg , (caddr_t) "",
-    toggleAction       , (optChecker) 0            },
+    toggleAction       , (optChecker) 0       , False },
   {"exit"              , XrmoptionNoArg , (caddr_t) "",
-    exitAction         , (optChecker) 0            },
+    exitAction         , (optChecker) 0       , False },
   {"locknow"           , XrmoptionNoArg , (caddr_t) "",
-    lockNowAction      , (optChecker) 0            },
+    lockNowAction      , (optChecker) 0       , False },
   {"unlocknow"         , XrmoptionNoArg , (caddr_t) "",
-    unlockNowAction    , (optChecker) 0            },
+    unlockNowAction    , (optChecker) 0       , False },
   {"restart"           , XrmoptionNoArg , (caddr_t) "",
-    restartAction      , (optChecker) 0            },
+    restartAction      , (optChecker) 0       , False },
+  {"reload"            , XrmoptionNoArg , (caddr_t) "",
+    reloadAction       , (optChecker) 0       , False },
+  {"status"            , XrmoptionNoArg , (caddr_t) "",
+    statusAction       , (optChecker) 0       , False },
+  {"stats"             , XrmoptionNoArg , (caddr_t) "",
+    statsAction        , (optChecker) 0       , False },
   {"resetsaver"        , XrmoptionNoArg , (caddr_t) "",
-    resetSaverAction   , (optChecker) 0            },
+    resetSaverAction   , (optChecker) 0       , True  },
   {"noclose"           , XrmoptionNoArg , (caddr_t) "",
-    noCloseAction      , (optChecker) 0            },
+    noCloseAction      , (optChecker) 0       , False },
   {"nocloseout"        , XrmoptionNoArg , (caddr_t) "",
-    noCloseOutAction   , (optChecker) 0            },
+    noCloseOutAction   , (optChecker) 0       , False },
   {"nocloseerr"        , XrmoptionNoArg , (caddr_t) "",
-    noCloseErrAction   , (optChecker) 0            },
+    noCloseErrAction   , (optChecker) 0       , False },
   {"detectsleep"       , XrmoptionNoArg , (caddr_t) "",
-    detectSleepAction  , (optChecker) 0            },
+    detectSleepAction  , (optChecker) 0       , False },
+  {"tickless"          , XrmoptionNoArg , (caddr_t) "",
+    ticklessAction     , ticklessChecker      , False },
+  {"diy"               , XrmoptionNoArg , (caddr_t) "",
+    forceDiyAction     , (optChecker) 0       , False },
+  {"noshell"           , XrmoptionNoArg , (caddr_t) "",
+    noShellAction      , noShellChecker       , False },
+  {"warmlocker"        , XrmoptionNoArg , (caddr_t) "",
+    warmLockerAction   , warmLockerChecker    , False },
+  {"statuspage"        , XrmoptionNoArg , (caddr_t) "",
+    writeStatusAction  , writeStatusChecker   , False },
+  {"journal"           , XrmoptionSepArg, (caddr_t) 0 ,
+    journalAction      , journalChecker       , False },
+  {"metrics"           , XrmoptionNoArg , (caddr_t) "",
+    serveMetricsAction , (optChecker) 0       , False },
+  {"metricsport"       , XrmoptionSepArg, (caddr_t) 0 ,
+    metricsPortAction  , metricsChecker       , False },
+  {"displays"          , XrmoptionSepArg, (caddr_t) 0 ,
+    displaysAction     , displaysChecker      , False },
 }; /* as it says, the order is important! */
 
 /*
@@ -563,10 +987,15 @@ usage (int exitCode)
   error1 ("%s[-notify margin][-notifier notifier][-bell percent]\n", blanks);
   error1 ("%s[-corners xxxx][-cornerdelay secs]\n", blanks);
   error1 ("%s[-cornerredelay secs][-cornersize pixels]\n", blanks);
+  error1 ("%s[-zones list]\n", blanks);
   error1 ("%s[-nocloseout][-nocloseerr][-noclose]\n", blanks);
   error1 ("%s[-enable][-disable][-toggle][-exit][-secure]\n", blanks);
   error1 ("%s[-locknow][-unlocknow][-nowlocker locker]\n", blanks);
-  error1 ("%s[-restart][-resetsaver][-detectsleep]\n", blanks);
+  error1 ("%s[-restart][-reload][-resetsaver][-detectsleep]\n", blanks);
+  error1 ("%s[-tickless]", blanks);
+  error0 ("[-diy][-status][-stats][-noshell][-warmlocker]\n");
+  error1 ("%s[-displays list][-statuspage][-journal file]\n", blanks);
+  error1 ("%s[-metrics][-metricsport port]\n", blanks);
 
   error0 ("\n");
   error0 (" -help               : print this message and exit.\n");
@@ -587,6 +1016,8 @@ usage (int exitCode)
   error0 (" -cornerdelay secs   : time to lock screen in a `+' corner.\n");
   error0 (" -cornerredelay secs : time to relock screen in a `+' corner.\n");
   error0 (" -cornersize pixels  : size of corner areas.\n");
+  error0 (" -zones list         : other areas acting like corners, e.g.\n");
+  error0 ("                       +4-0+0/3 (see the manual page).\n");
   error0 (" -nocloseout         : do not close stdout.\n");
   error0 (" -nocloseerr         : do not close stderr.\n");
   error0 (" -noclose            : close neither stdout nor stderr.\n");
@@ -596,12 +1027,30 @@ usage (int exitCode)
   error0 (" -locknow            : tell a running xautolock to lock.\n");
   error0 (" -unlocknow          : tell a running xautolock to unlock.\n");
   error0 (" -restart            : tell a running xautolock to restart.\n");
+  error0 (" -reload             : tell a running xautolock to reload"
+                                  " its resources.\n");
+  error0 (" -status             : ask a running xautolock how it is.\n");
+  error0 (" -stats              : ask a running xautolock how it went.\n");
   error0 (" -exit               : kill a running xautolock.\n");
   error0 (" -secure             : ignore enable, disable, toggle, locknow\n");
-  error0 ("                       unlocknow, and restart messages.\n");
+  error0 ("                       unlocknow, restart, and reload"
+                                  " messages.\n");
   error0 (" -resetsaver         : reset the screensaver when starting "
                                   "the locker.\n");
   error0 (" -detectsleep        : reset timers when awaking from sleep.\n");
+  error0 (" -tickless           : only wake up when there is something"
+                                  " to do.\n");
+  error0 (" -diy                : don't use any server extensions to"
+                                  " detect activity.\n");
+  error0 (" -noshell            : run simple commands without a shell.\n");
+  error0 (" -warmlocker         : keep a locker process ready to go.\n");
+  error0 (" -displays list      : watch these displays (\"auto\" for all"
+                                  " local ones).\n");
+  error0 (" -statuspage         : keep a status page for others to read.\n");
+  error0 (" -journal file       : keep a journal of what happened.\n");
+  error0 (" -metrics            : serve metrics for monitoring systems.\n");
+  error0 (" -metricsport port   : serve them on this port of localhost"
+                                  " too.\n");
 
   error0 ("\n");
   error0 ("Defaults :\n");
@@ -619,6 +1068,7 @@ usage (int exitCode)
   error1 ("  cornerdelay   : %d seconds\n"  , CORNER_DELAY);
   error1 ("  cornerredelay : %d seconds\n"  , CORNER_DELAY);
   error1 ("  cornersize    : %d pixels\n"   , CORNER_SIZE );
+  error0 ("  zones         : none\n"                      );
 
   error0 ("\n");
   error1 ("Version : %s\n", VERSION);
@@ -629,43 +1079,158 @@ usage (int exitCode)
 }
 
 /*
- *  Public interface to the above lot.
+ *  Functions for taking a snapshot of the settings and for going
+ *  back to one.
  */
-void
-processOpts (Display* d, int argc, char* argv[])
+static void
+saveSettings (settings* s)
 {
-  int                nofOptions = sizeof (options) / sizeof (options[0]);
-                                /* number of supported options   */
-  int                j;         /* loop counter                  */
-  unsigned           l;         /* temporary storage             */
-  unsigned           maxLen;    /* temporary storage             */
-  char*              dummy;     /* as it says                    */
-  char*              fullname;  /* full resource name            */
-  char*              str;       /* temporary storage             */
-  XrmValue           value;     /* resource value container      */
-  XrmOptionDescList  xoptions;  /* optionslist in Xlib format    */
-  XrmDatabase        rescDb = (XrmDatabase) 0;
-                                /* resource file database        */
-  XrmDatabase        cmdlDb = (XrmDatabase) 0;
-                                /* command line options database */
+  s->locker = locker;
+  s->nowLocker = nowLocker;
+  s->notifier = notifier;
+  s->killer = killer;
+  s->lockTime = lockTime;
+  s->killTime = killTime;
+  s->notifyMargin = notifyMargin;
+  s->cornerDelay = cornerDelay;
+  s->cornerRedelay = cornerRedelay;
+  s->bellPercent = bellPercent;
+  s->cornerSize = cornerSize;
+  s->notifyLock = notifyLock;
+  s->resetSaver = resetSaver;
+  (void) memcpy (s->corners, corners, sizeof (corners));
+  s->zones = zones;
+  s->nofZones = nofZones;
+  s->lockerArgv = lockerArgv;
+  s->nowLockerArgv = nowLockerArgv;
+  s->notifierArgv = notifierArgv;
+  s->killerArgv = killerArgv;
+#ifdef VMS
+  s->lockerDescr = lockerDescr;
+  s->nowLockerDescr = nowLockerDescr;
+#endif /* VMS */
+  s->notifierSpecified = notifierSpecified;
+  s->killerSpecified = killerSpecified;
+  s->killTimeSpecified = killTimeSpecified;
+  s->redelaySpecified = redelaySpecified;
+  s->bellSpecified = bellSpecified;
+}
 
- /*
-  *  Collect defaults from various places except the command line into one
-  *  resource database, then parse the command line options into an other.
-  *  Both databases are not merged, because we want to know where exactly
-  *  each resource value came from.
-  *
-  *  One day I might extend this stuff to fully cover *all* possible
-  *  resource value sources, but... One of the problems is that various
-  *  pieces of documentation make conflicting claims with respect to the
-  *  proper order in which resource value sources should be accessed.
-  */
-  XrmInitialize ();
+static void
+loadSettings (const settings* s)
+{
+  locker = s->locker;
+  nowLocker = s->nowLocker;
+  notifier = s->notifier;
+  killer = s->killer;
+  lockTime = s->lockTime;
+  killTime = s->killTime;
+  notifyMargin = s->notifyMargin;
+  cornerDelay = s->cornerDelay;
+  cornerRedelay = s->cornerRedelay;
+  bellPercent = s->bellPercent;
+  cornerSize = s->cornerSize;
+  notifyLock = s->notifyLock;
+  resetSaver = s->resetSaver;
+  (void) memcpy (corners, s->corners, sizeof (corners));
+  zones = s->zones;
+  nofZones = s->nofZones;
+  lockerArgv = s->lockerArgv;
+  nowLockerArgv = s->nowLockerArgv;
+  notifierArgv = s->notifierArgv;
+  killerArgv = s->killerArgv;
+#ifdef VMS
+  lockerDescr = s->lockerDescr;
+  nowLockerDescr = s->nowLockerDescr;
+#endif /* VMS */
+  notifierSpecified = s->notifierSpecified;
+  killerSpecified = s->killerSpecified;
+  killTimeSpecified = s->killTimeSpecified;
+  redelaySpecified = s->redelaySpecified;
+  bellSpecified = s->bellSpecified;
+}
 
-  if (XResourceManagerString (d))
+#ifdef HasPosixSpawn
+/*
+ *  Function for getting rid of what splitCommand () returned, which
+ *  keeps all of the arguments in the buffer of the first one.
+ */
+static void
+freeArgv (char** argv)
+{
+  if (argv)
+  {
+    free (argv[0]);
+    free (argv);
+  }
+}
+#endif /* HasPosixSpawn */
+
+/*
+ *  Function for getting rid of whatever the checkers allocated for
+ *  a set of settings. Which commands they copied follows from what
+ *  the copies look like, see addExecToCommand () and friends.
+ */
+static void
+freeSettings (const settings* s)
+{
+  if (s->zones) free (s->zones);
+
+#ifndef VMS
+  if (!strchr (s->locker, ';')) free ((char*) s->locker);
+  if (!strchr (s->nowLocker, ';')) free ((char*) s->nowLocker);
+  if (s->notifyLock && strcmp (s->notifier, "")) free ((char*) s->notifier);
+  if (strcmp (s->killer, "")) free ((char*) s->killer);
+#endif /* !VMS */
+
+#ifdef HasPosixSpawn
+  freeArgv (s->lockerArgv);
+  freeArgv (s->nowLockerArgv);
+  freeArgv (s->notifierArgv);
+  freeArgv (s->killerArgv);
+#endif /* HasPosixSpawn */
+}
+
+/*
+ *  Function for collecting defaults from various places except the
+ *  command line into one resource database.
+ *
+ *  Xlib only reads the RESOURCE_MANAGER property of the display when
+ *  connecting to it, so XResourceManagerString () keeps on telling the
+ *  same old story. When reloading, we need to go and get it ourselves.
+ */
+static XrmDatabase
+getResources (Display* d, Bool reloading)
+{
+  XrmDatabase   rescDb = (XrmDatabase) 0; /* as it says           */
+  char*         str;                      /* temporary storage    */
+  char*         fresh = 0;                /* the property, if any */
+  Atom          type;                     /* of the property      */
+  int           format;                   /* ditto                */
+  unsigned long nofItems;                 /* ditto                */
+  unsigned long after;                    /* ditto                */
+
+  if (!reloading)
   {
-    XrmMergeDatabases (XrmGetStringDatabase (XResourceManagerString (d)),
-		       &rescDb);
+    str = XResourceManagerString (d);
+  }
+  else if (   XGetWindowProperty (d, RootWindow (d, 0), XA_RESOURCE_MANAGER,
+                                  0L, 100000000L, False, XA_STRING, &type,
+                                  &format, &nofItems, &after,
+                                  (unsigned char**) &fresh)
+           == Success
+           && type == XA_STRING)
+  {
+    str = fresh;
+  }
+  else
+  {
+    str = 0;
+  }
+
+  if (str)
+  {
+    XrmMergeDatabases (XrmGetStringDatabase (str), &rescDb);
   }
   else if ((str = getenv ("XENVIRONMENT"))) /* = intended */
   {
@@ -719,6 +1284,36 @@ processOpts (Display* d, int argc, char* argv[])
   }
 #endif /* ReadXdefaultsFile && !VMS */
 
+  if (fresh) XFree (fresh);
+
+  return rescDb;
+}
+
+/*
+ *  Function for parsing the command line into an other resource
+ *  database, and calling the action functions and consistency checkers
+ *  of all options (or of only those that -reload applies to). Both
+ *  databases end up in dbs, as the settings may point into them. 
+ *  Returns whether all of the values made sense.
+ */
+static Bool
+applyOpts (Display* d, int argc, char* argv[], XrmDatabase rescDb,
+           Bool reloading, XrmDatabase dbs[2])
+{
+  int                nofOptions = sizeof (options) / sizeof (options[0]);
+                                /* number of supported options   */
+  int                j;         /* loop counter                  */
+  unsigned           l;         /* temporary storage             */
+  unsigned           maxLen;    /* temporary storage             */
+  char*              dummy;     /* as it says                    */
+  char*              fullname;  /* full resource name            */
+  XrmValue           value;     /* resource value container      */
+  XrmOptionDescList  xoptions;  /* optionslist in Xlib format    */
+  XrmDatabase        cmdlDb = (XrmDatabase) 0;
+                                /* command line options database */
+  Bool               retVal = True;
+                                /* as it says                    */
+
   xoptions = newArray (XrmOptionDescRec, nofOptions);
 
   for (j = -1, maxLen = 0; ++j < nofOptions; )
@@ -753,6 +1348,8 @@ processOpts (Display* d, int argc, char* argv[])
   */
   for (j = -1; ++j < nofOptions; )
   {
+    if (reloading && !options[j].reload) continue;
+
     (void) sprintf (fullname, "%s%s", progName, xoptions[j].specifier);
 
     if (   XrmGetResource (cmdlDb, fullname, DUMMY_RES_CLASS,
@@ -761,7 +1358,8 @@ processOpts (Display* d, int argc, char* argv[])
     {
       if (!(*(options[j].action)) (d, value.addr))
       {
-	usage (EXIT_FAILURE); 
+        if (!reloading) usage (EXIT_FAILURE); 
+        retVal = False;
       }
     }
     else if (   XrmGetResource (rescDb, fullname, DUMMY_RES_CLASS,
@@ -772,6 +1370,7 @@ processOpts (Display* d, int argc, char* argv[])
       {
         error2 ("Can't interprete \"%s\" for \"%s\", using default.\n", 
                 value.addr, fullname);
+        retVal = False;
       }
     }
     else
@@ -785,6 +1384,7 @@ processOpts (Display* d, int argc, char* argv[])
       {
         error2 ("Can't interprete \"%s\" for \"%s\", using default.\n", 
                 value.addr, fullname);
+        retVal = False;
       }
     }
   }
@@ -794,6 +1394,8 @@ processOpts (Display* d, int argc, char* argv[])
   */
   for (j = -1; ++j < nofOptions; )
   {
+    if (reloading && !options[j].reload) continue;
+
     if (options[j].checker != (optChecker) NULL)
     {
       (*(options[j].checker)) (d);
@@ -801,10 +1403,11 @@ processOpts (Display* d, int argc, char* argv[])
   }
 
  /*
-  *  General clean up.
+  *  General clean up. The databases stay, since the settings point
+  *  into them.
   */
-  XrmDestroyDatabase (cmdlDb);
-  XrmDestroyDatabase (rescDb);
+  dbs[0] = cmdlDb;
+  dbs[1] = rescDb;
 
   for (j = -1; ++j < nofOptions; )
   {
@@ -814,4 +1417,85 @@ processOpts (Display* d, int argc, char* argv[])
 
   free (xoptions);
   free (fullname);
+
+  return retVal;
+}
+
+/*
+ *  Public interface to the above lot.
+ */
+void
+processOpts (Display* d, int argc, char* argv[])
+{
+  XrmDatabase dbs[2]; /* as it says */
+
+ /*
+  *  Collect defaults from various places except the command line into one
+  *  resource database, then parse the command line options into an other.
+  *  Both databases are not merged, because we want to know where exactly
+  *  each resource value came from.
+  *
+  *  One day I might extend this stuff to fully cover *all* possible
+  *  resource value sources, but... One of the problems is that various
+  *  pieces of documentation make conflicting claims with respect to the
+  *  proper order in which resource value sources should be accessed.
+  */
+  XrmInitialize ();
+  saveSettings (&defaults);
+  (void) applyOpts (d, argc, argv, getResources (d, False), False, dbs);
+}
+
+/*
+ *  Function for reloading the settings, as if we were starting all
+ *  over again with the same command line, but with whatever the X
+ *  resources say by now. Options that decide how things get set up
+ *  (e.g. -tickless or -displays) are left alone, and so is -secure.
+ *  Either all of the new settings are taken on board, or none of them
+ *  are. Returns which of the two it was.
+ */
+Bool
+reloadOpts (Display* d)
+{
+  settings    old;   /* as it says                     */
+  settings    failed;/* ditto, for the new ones        */
+  char**      argv;  /* copy of argArray, see below    */
+  int         argc;  /* as it says                     */
+  XrmDatabase dbs[2];/* as it says                     */
+  Bool        ok;    /* as it says                     */
+
+ /*
+  *  XrmParseCommand () shuffles the arguments around.
+  */
+  for (argc = 0; argArray[argc]; ++argc)
+  {
+    /* count them */
+  }
+
+  argv = newArray (char*, argc + 1);
+  (void) memcpy (argv, argArray, (argc + 1) * sizeof (char*));
+
+  saveSettings (&old);
+  loadSettings (&defaults);
+  ok = applyOpts (d, argc, argv, getResources (d, True), True, dbs);
+  free (argv);
+
+  if (!ok)
+  {
+    saveSettings (&failed);
+    freeSettings (&failed);
+    loadSettings (&old);
+    XrmDestroyDatabase (dbs[0]);
+    XrmDestroyDatabase (dbs[1]);
+    error0 ("Keeping the old settings.\n");
+    return False;
+  }
+
+  freeSettings (&old);
+  XrmDestroyDatabase (reloadedDbs[0]);
+  XrmDestroyDatabase (reloadedDbs[1]);
+  reloadedDbs[0] = dbs[0];
+  reloadedDbs[1] = dbs[1];
+  ++reloads;
+
+  return True;
 }
@@ -0,0 +1,335 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It implements
+ *          the bookkeeping needed for watching more than one display
+ *          at once (see -displays).
+ *
+ *          Most of xautolock keeps what it knows about the display in
+ *          global (or file static) variables. Rather than dragging a
+ *          pointer to some big structure through every function, each
+ *          session keeps its own copy of those variables, which gets
+ *          loaded before looking after its display and saved again
+ *          afterwards. That only costs a few dozen assignments, and
+ *          leaves the single display case alone altogether.
+ *
+ *          Sessions are kept in a heap ordered by the time at which
+ *          they need to be looked after again, so that finding the
+ *          next one to wake up for doesn't depend on how many there
+ *          are. The displays to watch are either listed explicitly,
+ *          or found by looking at the sockets of the local X servers.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#include "session.h"
+#include "options.h"
+#include "journal.h"
+#include "miscutil.h"
+
+#ifdef HasPoll
+
+#define X11_SOCKET_DIR  "/tmp/.X11-unix"  /* where local servers listen */
+
+session**       sessions = 0;         /* all of them, in heap order     */
+unsigned        nofSessions = 0;      /* as it says                     */
+static unsigned maxSessions = 0;      /* room in the above              */
+static Bool     autoDiscover = False; /* whether to look for displays   */
+static int      notifyFd = -1;        /* tells us when to look again    */
+
+/*
+ *  Deadline heap support. The session due first sits at the top.
+ */
+static void
+placeSession (session* s, unsigned slot)
+{
+  sessions[slot] = s;
+  s->slot = slot;
+}
+
+static void
+siftUp (session* s)
+{
+  unsigned slot = s->slot; /* as it says */
+
+  while (slot && sessions[(slot - 1) / 2]->due > s->due)
+  {
+    placeSession (sessions[(slot - 1) / 2], slot);
+    slot = (slot - 1) / 2;
+  }
+
+  placeSession (s, slot);
+}
+
+static void
+siftDown (session* s)
+{
+  unsigned slot = s->slot; /* as it says         */
+  unsigned child;          /* earliest child due */
+
+  while ((child = 2 * slot + 1) < nofSessions) /* = intended */
+  {
+    if (   child + 1 < nofSessions
+        && sessions[child + 1]->due < sessions[child]->due)
+    {
+      ++child;
+    }
+
+    if (sessions[child]->due >= s->due) break;
+
+    placeSession (sessions[child], slot);
+    slot = child;
+  }
+
+  placeSession (s, slot);
+}
+
+void
+scheduleSession (session* s, time_t due)
+{
+  s->due = due;
+  siftUp (s);
+  siftDown (s);
+}
+
+/*
+ *  Functions for starting and stopping to keep track of a display.
+ *  New sessions are due immediately, which will get their display
+ *  opened.
+ */
+static session*
+addSession (const char* name)
+{
+  session* s; /* as it says */
+
+  if (nofSessions == maxSessions)
+  {
+    session** old = sessions; /* as it says */
+
+    maxSessions = maxSessions ? maxSessions * 2 : 16;
+    sessions = newArray (session*, maxSessions);
+
+    if (old)
+    {
+      (void) memcpy (sessions, old, nofSessions * sizeof (session*));
+      free (old);
+    }
+  }
+
+  s = newObj (session);
+  (void) memset (s, 0, sizeof (*s));
+  s->name = strdup (name);
+  s->stats = newStats (name);
+  s->state.lockerFd = -1;
+  s->state.lockLatency = -1;
+  s->state.lockHistogram = newObj (histogram);
+  (void) memset (s->state.lockHistogram, 0, sizeof (histogram));
+  initEngineState (&s->engine);
+
+  placeSession (s, nofSessions++);
+  scheduleSession (s, 0);
+
+  return s;
+}
+
+void
+dropSession (session* s)
+{
+  session* last = sessions[--nofSessions]; /* as it says */
+
+  if (last != s)
+  {
+    placeSession (last, s->slot);
+    scheduleSession (last, last->due);
+  }
+
+  if (s->engine.rootMasks) free (s->engine.rootMasks);
+  free (s->state.lockHistogram);
+  freeMonitorState (&s->monitors);
+  freeStats (s->stats);
+  free (s->name);
+  free (s);
+}
+
+/*
+ *  Functions for switching between sessions. Anything we start on
+ *  behalf of a session should end up on its display, so that goes
+ *  into the environment too.
+ */
+void
+enterSession (session* s)
+{
+  loadState (&s->state);
+  loadEngineState (&s->engine);
+  loadMessageState (&s->message);
+  loadMonitorState (&s->monitors);
+  loadStatusPage (s->status);
+  journalDisplay (s->name);
+  loadStats (s->stats);
+  (void) setenv ("DISPLAY", s->name, 1);
+}
+
+void
+leaveSession (session* s)
+{
+  saveState (&s->state);
+  saveEngineState (&s->engine);
+  saveMessageState (&s->message);
+  saveMonitorState (&s->monitors);
+  saveStatusPage (&s->status);
+}
+
+/*
+ *  Function for finding out which displays there are, in -displays
+ *  auto mode. A server listening on /tmp/.X11-unix/X3 is display :3.
+ *  Sessions of displays that are no longer there are marked as gone
+ *  and made due, so that they get cleaned up.
+ */
+void
+scanDisplays (void)
+{
+  DIR*           dir;       /* as it says                */
+  struct dirent* entry;     /* as it says                */
+  char           name[32];  /* display name              */
+  unsigned       i;         /* loop counter              */
+  unsigned       found;     /* matching session, if any  */
+
+  if (!autoDiscover) return;
+
+#ifdef HasInotify
+  if (notifyFd >= 0)
+  {
+    char buffer[1024]; /* we only care about there being events */
+
+    while (read (notifyFd, buffer, sizeof (buffer)) > 0)
+    {
+      /* drain it */
+    }
+  }
+#endif /* HasInotify */
+
+  for (i = 0; i < nofSessions; ++i)
+  {
+    sessions[i]->seen = False;
+  }
+
+  if ((dir = opendir (X11_SOCKET_DIR))) /* = intended */
+  {
+    while ((entry = readdir (dir))) /* = intended */
+    {
+      if (   entry->d_name[0] != 'X'
+          || !entry->d_name[1]
+          || strspn (entry->d_name + 1, "0123456789")
+             != strlen (entry->d_name + 1)
+          || strlen (entry->d_name) >= sizeof (name) - 1)
+      {
+        continue;
+      }
+
+      (void) sprintf (name, ":%s", entry->d_name + 1);
+
+      for (i = 0, found = nofSessions; i < nofSessions; ++i)
+      {
+        if (!strcmp (sessions[i]->name, name))
+        {
+          found = i;
+          break;
+        }
+      }
+
+      if (found < nofSessions)
+      {
+        sessions[found]->seen = True;
+      }
+      else
+      {
+        addSession (name)->seen = True;
+      }
+    }
+
+    (void) closedir (dir);
+  }
+
+ /*
+  *  Making the ones that are gone due messes up the heap, so put
+  *  it back in order afterwards.
+  */
+  for (i = 0; i < nofSessions; ++i)
+  {
+    if (!sessions[i]->seen)
+    {
+      sessions[i]->gone = True;
+      sessions[i]->due = 0;
+    }
+  }
+
+  for (i = nofSessions / 2; i-- > 0; )
+  {
+    siftDown (sessions[i]);
+  }
+}
+
+/*
+ *  Function for finding out which file descriptor (if any) becomes
+ *  readable when it is time to call scanDisplays() again. Returns
+ *  -1 if there is none, in which case the caller will have to call
+ *  it every now and then.
+ */
+int
+watchDisplays (void)
+{
+  return notifyFd;
+}
+
+/*
+ *  Function for setting up the lot. The list of displays can be
+ *  separated by commas or white space.
+ */
+void
+initSessions (const char* list)
+{
+  char* copy = strdup (list); /* as it says */
+  char* name;                 /* as it says */
+
+  if (!strcmp (list, "auto"))
+  {
+    autoDiscover = True;
+
+#ifdef HasInotify
+    if ((notifyFd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC)) >= 0)
+    {
+      if (inotify_add_watch (notifyFd, X11_SOCKET_DIR,
+                               IN_CREATE | IN_DELETE
+                             | IN_MOVED_FROM | IN_MOVED_TO) < 0)
+      {
+        (void) close (notifyFd);
+        notifyFd = -1;
+      }
+    }
+#endif /* HasInotify */
+
+    scanDisplays ();
+  }
+  else
+  {
+    for (name = strtok (copy, ", \t\n"); name; name = strtok (0, ", \t\n"))
+    {
+      (void) addSession (name);
+    }
+  }
+
+  free (copy);
+}
+
+#endif /* HasPoll */
@@ -30,7 +30,16 @@ Bool        lockNow     = False; /* whether to lock immediately        */
 Bool        unlockNow   = False; /* whether to unlock immediately      */
 time_t      lockTrigger = 0;     /* time at which to invoke the locker */
 time_t      killTrigger = 0;     /* time at which to invoke the killer */
+time_t      lastActivity = 0;    /* time of the last user activity     */
 pid_t       lockerPid   = 0;     /* process id of the current locker   */
+Bool        leave       = False; /* whether to stop watching a display */
+int         lockerFd    = -1;    /* pidfd of the current locker        */
+unsigned long xErrors   = 0;     /* number of X errors ignored so far  */
+long        lockLatency = -1;    /* microseconds the last lock took    */
+double      lockRequested = 0.0; /* when we were told to lock, if so   */
+static histogram latencies;       /* see below                          */
+histogram*  lockHistogram = &latencies;
+                                 /* how long it took to secure screens */
 
 /*
  *  Please have a guess what this is for... :-)
@@ -81,3 +90,117 @@ initState (int argc, char* argv[])
   }
 #endif /* VMS */
 }
+
+/*
+ *  The clock all of the triggers run on. Where possible, we use one
+ *  that doesn't care about anybody setting the system time (be it by
+ *  hand or by NTP), but that does keep on running while the machine
+ *  is asleep. That way, a lock that was due during a suspend is still
+ *  due on resume, as it always has been.
+ */
+time_t
+currentTime (void)
+{
+#ifdef HasBoottime
+  struct timespec ts;
+
+  if (!clock_gettime (CLOCK_BOOTTIME, &ts)) return ts.tv_sec;
+#endif /* HasBoottime */
+
+  return time ((time_t*) 0);
+}
+
+/*
+ *  A clock with sub-second resolution, for timing how long things
+ *  take rather than for deciding when to do them. Returns seconds
+ *  since some arbitrary point in time.
+ */
+double
+preciseTime (void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+
+  if (!clock_gettime (CLOCK_MONOTONIC, &ts)) 
+  {
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+#endif /* CLOCK_MONOTONIC */
+
+  {
+    struct timeval tv;
+
+    (void) gettimeofday (&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+  }
+}
+
+/*
+ *  Functions for switching between displays in multi-display mode.
+ */
+void
+saveState (displayState* s)
+{
+  s->disabled = disabled;
+  s->lockNow = lockNow;
+  s->unlockNow = unlockNow;
+  s->leave = leave;
+  s->lockTrigger = lockTrigger;
+  s->killTrigger = killTrigger;
+  s->lastActivity = lastActivity;
+  s->lockerPid = lockerPid;
+  s->lockerFd = lockerFd;
+  s->lockRequested = lockRequested;
+  s->lockLatency = lockLatency;
+  s->lockHistogram = lockHistogram;
+}
+
+void
+loadState (const displayState* s)
+{
+  disabled = s->disabled;
+  lockNow = s->lockNow;
+  unlockNow = s->unlockNow;
+  leave = s->leave;
+  lockTrigger = s->lockTrigger;
+  killTrigger = s->killTrigger;
+  lastActivity = s->lastActivity;
+  lockerPid = s->lockerPid;
+  lockerFd = s->lockerFd;
+  lockRequested = s->lockRequested;
+  lockLatency = s->lockLatency;
+  lockHistogram = s->lockHistogram;
+}
+
+/*
+ *  Find out for how long the machine has been asleep since the last 
+ *  time we asked. The kernel tells us exactly: CLOCK_BOOTTIME keeps
+ *  running during a suspend, CLOCK_MONOTONIC doesn't. Returns -1 if 
+ *  we can't tell, in which case the caller will have to guess.
+ */
+time_t
+timeAsleep (void)
+{
+#ifdef HasBoottime
+  static double   prevOffset = -1.0; /* previous boot - mono time */
+  double          offset;            /* current boot - mono time  */
+  struct timespec boot, mono;        /* as it says                */
+  time_t          result = 0;        /* as it says                */
+
+  if (   clock_gettime (CLOCK_BOOTTIME, &boot)
+      || clock_gettime (CLOCK_MONOTONIC, &mono))
+  {
+    return -1;
+  }
+
+  offset =   (double) (boot.tv_sec - mono.tv_sec)
+           + (boot.tv_nsec - mono.tv_nsec) / 1e9;
+
+  if (prevOffset >= 0.0) result = (time_t) (offset - prevOffset);
+  prevOffset = offset;
+
+  return result;
+#else /* HasBoottime */
+  return -1;
+#endif /* HasBoottime */
+}
@@ -0,0 +1,255 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It implements
+ *          the stuff used for keeping running statistics about user
+ *          activity and locking (see -stats).
+ *
+ *          The journal (see journal.c) tells what happened, but adding
+ *          it all up for hundreds of sessions is a chore. So each
+ *          display also gets a fixed amount of counters, which the
+ *          engine bumps as it goes: how long the user tends to stay
+ *          idle (see histogram.c), how long the screen has been locked,
+ *          how often it got locked on each of the last STATS_DAYS days
+ *          and why, and how often a notification was followed by the
+ *          user coming back rather than by the locker. They can be
+ *          asked for through the control socket, and are written to
+ *          stderr when we exit.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#include "stats.h"
+#include "histogram.h"
+#include "options.h"
+#include "state.h"
+#include "miscutil.h"
+
+#define STATS_DAYS  7  /* days to count locks for */
+
+struct activityStats
+{
+  char*          name;                /* display name, for reporting   */
+  histogram      idle;                /* idle stretches, in seconds    */
+  time_t         locked;              /* seconds spent locked so far   */
+  time_t         lockedSince;         /* when the locker started, or 0 */
+  unsigned long  locks[nofLockSources];             /* as it says      */
+  long           days[STATS_DAYS];    /* YYYYMMDD of each slot, or 0   */
+  unsigned long  daily[STATS_DAYS][nofLockSources]; /* as it says      */
+  unsigned long  notified;            /* notifications given           */
+  unsigned long  putOff;              /* ... not followed by a lock    */
+  Bool           notifyPending;       /* whether one awaits a verdict  */
+  activityStats* next;                /* all of them, for reportStats  */
+};
+
+static activityStats* current = 0; /* the one of the display at hand */
+static activityStats* all = 0;     /* all of them                    */
+
+/*
+ *  Find out which day it is, and which slot it goes into. This takes
+ *  the wall clock, since currentTime () need not count from the epoch
+ *  (see state.c).
+ */
+static long
+today (unsigned* slot)
+{
+  time_t     now = time ((time_t*) 0); /* as it says */
+  struct tm* tm = localtime (&now);    /* as it says */
+
+  *slot = (unsigned) tm->tm_yday % STATS_DAYS;
+  return   (tm->tm_year + 1900L) * 10000 + (tm->tm_mon + 1) * 100
+         + tm->tm_mday;
+}
+
+static void
+reportStats (void)
+{
+  char           text[256];  /* as it says   */
+  activityStats* s;          /* loop counter */
+  unsigned       i;          /* loop counter */
+
+  if (!noCloseErr) return; /* nobody to tell */
+
+  for (s = all; s; s = s->next)
+  {
+    current = s;
+    formatStats (text, sizeof (text));
+    (void) fprintf (stderr, "%s: %s: %s", progName, s->name, text);
+
+    for (i = 0; i < STATS_DAYS; ++i)
+    {
+      if (!s->days[i]) continue;
+
+      (void) fprintf (stderr, "%s: %s: %04ld-%02ld-%02ld"
+                              " locks=%lu/%lu/%lu\n",
+                      progName, s->name, s->days[i] / 10000,
+                      s->days[i] / 100 % 100, s->days[i] % 100,
+                      s->daily[i][ls_timeout], s->daily[i][ls_corner],
+                      s->daily[i][ls_lockNow]);
+    }
+  }
+}
+
+/*
+ *  Functions for creating and getting rid of the statistics of a
+ *  display, and for making them the ones at hand.
+ */
+activityStats*
+newStats (const char* name)
+{
+  activityStats* s = newObj (activityStats); /* as it says */
+
+  if (!all) (void) atexit (reportStats);
+
+  (void) memset (s, 0, sizeof (*s));
+  s->name = strdup (name);
+  s->next = all;
+  all = s;
+
+  return s;
+}
+
+void
+freeStats (activityStats* s)
+{
+  activityStats** p; /* iterator */
+
+  for (p = &all; *p != s; p = &(*p)->next)
+  {
+    /* find it */
+  }
+
+  *p = s->next;
+  if (current == s) current = 0;
+  free (s->name);
+  free (s);
+}
+
+void
+loadStats (activityStats* s)
+{
+  current = s;
+}
+
+/*
+ *  Functions for the engine to tell what happened.
+ */
+void
+noteIdleStretch (time_t length)
+{
+  if (current) addToHistogram (&current->idle, (long) length);
+}
+
+void
+noteNotification (void)
+{
+  if (!current) return;
+
+  ++current->notified;
+  current->notifyPending = True;
+}
+
+/*
+ *  A notification that is no longer followed by a lock within the
+ *  notification margin has been put off, usually by the user.
+ */
+void
+noteLockPutOff (time_t now)
+{
+  if (   current
+      && current->notifyPending
+      && lockTrigger > now + notifyMargin)
+  {
+    ++current->putOff;
+    current->notifyPending = False;
+  }
+}
+
+void
+noteLockStarted (lockSource source)
+{
+  time_t   now = currentTime (); /* as it says */
+  long     day;                  /* as it says */
+  unsigned slot;                 /* as it says */
+
+  if (!current) return;
+
+  day = today (&slot);
+
+  if (current->days[slot] != day)
+  {
+    current->days[slot] = day;
+    (void) memset (current->daily[slot], 0, sizeof (current->daily[slot]));
+  }
+
+  ++current->locks[source];
+  ++current->daily[slot][source];
+  current->lockedSince = now;
+  current->notifyPending = False;
+}
+
+void
+noteLockEnded (void)
+{
+  if (!current || !current->lockedSince) return;
+
+  current->locked += currentTime () - current->lockedSince;
+  current->lockedSince = 0;
+}
+
+/*
+ *  Function for describing the statistics at hand in a single line.
+ *  See control.c for what it looks like.
+ */
+void
+formatStats (char* text, size_t size)
+{
+  const histogram* idle;                  /* as it says                */
+  unsigned long    zero[nofLockSources];  /* for days without locks    */
+  unsigned long*   day = zero;            /* today's counts            */
+  time_t           now = currentTime ();  /* as it says                */
+  time_t           locked;                /* including the current one */
+  long             key;                   /* today, as in days[]       */
+  unsigned         slot;                  /* as it says                */
+
+  if (!current)
+  {
+    (void) snprintf (text, size, "none\n");
+    return;
+  }
+
+  (void) memset (zero, 0, sizeof (zero));
+
+  key = today (&slot);
+
+  if (current->days[slot] == key)
+  {
+    day = current->daily[slot];
+  }
+
+  idle = &current->idle;
+  locked = current->locked;
+  if (current->lockedSince) locked += now - current->lockedSince;
+
+  (void) snprintf (text, size,
+                   "idle=%lu/%ld/%ld/%ld locked=%ld locks=%lu/%lu/%lu"
+                   " today=%lu/%lu/%lu notified=%lu putoff=%lu\n",
+                   idle->total, histogramPercentile (idle, 50),
+                   histogramPercentile (idle, 99),
+                   idle->total ? idle->max : -1L, (long) locked,
+                   current->locks[ls_timeout], current->locks[ls_corner],
+                   current->locks[ls_lockNow], day[ls_timeout],
+                   day[ls_corner], day[ls_lockNow], current->notified,
+                   current->putOff);
+}
@@ -0,0 +1,224 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It implements
+ *          the stuff used for publishing how xautolock is doing in a
+ *          memory mapped file (see -statuspage).
+ *
+ *          The control socket (see control.c) can tell the same, but
+ *          asking it takes a couple of system calls and a trip through
+ *          our main loop. Programs keeping an eye on lots of sessions
+ *          would rather just look. So we keep a file in $XDG_RUNTIME_DIR
+ *          (or in our own directory in /tmp) next to the socket, which
+ *          they can map into memory and read whenever they like. A
+ *          sequence counter that is odd while we are halfway through
+ *          updating it tells them whether what they read is consistent
+ *          (see statuspage.h).
+ *
+ *          The page gets updated after each evaluation of the triggers,
+ *          which is when whatever happened since last time (user input,
+ *          messages, lockers coming and going) has been accounted for.
+ *          If nothing changed, the page isn't touched at all.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#include "config.h"
+#include "statuspage.h"
+#include "control.h"
+#include "options.h"
+#include "state.h"
+#include "miscutil.h"
+
+#ifdef HasMmap
+
+#ifndef O_NOFOLLOW
+#define O_NOFOLLOW  0  /* O_EXCL will have to do */
+#endif /* O_NOFOLLOW */
+
+struct statusFile
+{
+  statusPage* page;  /* as it says                     */
+  char*       path;  /* as it says                     */
+  statusFile* next;  /* all of them, for removeFiles() */
+};
+
+static statusFile* current = 0; /* the one of the display at hand */
+static statusFile* files = 0;   /* all of them                    */
+
+static void
+removeFiles (void)
+{
+  statusFile* f; /* loop counter */
+
+  for (f = files; f; f = f->next) (void) unlink (f->path);
+}
+
+#endif /* HasMmap */
+
+/*
+ *  Function for creating the page of a display. Failing to do so
+ *  isn't fatal, we just do without.
+ */
+void
+initStatusPage (Display* d)
+{
+#ifdef HasMmap
+  char            path[1024]; /* as it says   */
+  int             fd;         /* as it says   */
+  void*           page;       /* as it says   */
+  struct stat     info;       /* as it says   */
+  statusFile*     f;          /* as it says   */
+#ifdef HasBoottime
+  struct timespec ts;         /* as it says   */
+#endif /* HasBoottime */
+
+  current = 0;
+
+  if (!writeStatus) return;
+
+  if (!runtimePath (d, ".status", path, sizeof (path)))
+  {
+    error0 ("No safe place for the status page, not using it.\n");
+    return;
+  }
+
+ /*
+  *  Any file already there is a leftover, so start from scratch. If
+  *  something shows up in its place all the same, it isn't ours, and
+  *  neither is whatever a symbolic link there points to.
+  */
+  (void) unlink (path);
+
+  if (   (fd = open (path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW,
+                     0644)) < 0
+      || fstat (fd, &info) < 0
+      || !S_ISREG (info.st_mode)
+      || info.st_uid != getuid ()
+      || ftruncate (fd, sizeof (statusPage)) < 0
+      || (page = mmap (0, sizeof (statusPage), PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0)) == MAP_FAILED)
+  {
+    error1 ("Couldn't set up the status page in %s.\n", path);
+    if (fd >= 0) (void) close (fd);
+    return;
+  }
+
+  (void) close (fd);
+
+  if (!files) (void) atexit (removeFiles);
+
+  f = newObj (statusFile);
+  f->page = (statusPage*) page;
+  f->path = strdup (path);
+  f->next = files;
+  files = current = f;
+
+  f->page->pid = getpid ();
+  f->page->clock = STATUS_REALTIME;
+
+#ifdef HasBoottime
+  if (!clock_gettime (CLOCK_BOOTTIME, &ts)) f->page->clock = STATUS_BOOTTIME;
+#endif /* HasBoottime */
+
+  f->page->version = STATUS_VERSION;
+  statusBarrier ();
+  f->page->magic = STATUS_MAGIC;
+  updateStatusPage ();
+#endif /* HasMmap */
+}
+
+/*
+ *  Function for getting rid of the page of the display at hand.
+ */
+void
+closeStatusPage (void)
+{
+#ifdef HasMmap
+  statusFile** f; /* iterator */
+
+  if (!current) return;
+
+  for (f = &files; *f != current; f = &(*f)->next)
+  {
+    /* find it */
+  }
+
+  *f = current->next;
+  (void) unlink (current->path);
+  (void) munmap ((void*) current->page, sizeof (statusPage));
+  free (current->path);
+  free (current);
+  current = 0;
+#endif /* HasMmap */
+}
+
+/*
+ *  Function for bringing the page up to date.
+ */
+void
+updateStatusPage (void)
+{
+#ifdef HasMmap
+  statusPage* page;  /* as it says */
+
+  if (!current) return;
+
+  page = current->page;
+
+  if (   page->disabled == (disabled ? 1 : 0)
+      && page->lastActivity == lastActivity
+      && page->lockTrigger == lockTrigger
+      && page->killTrigger == killTrigger
+      && page->lockerPid == lockerPid
+      && page->updated)
+  {
+    return;
+  }
+
+  ++page->sequence;
+  statusBarrier ();
+
+  page->disabled = disabled ? 1 : 0;
+  page->lastActivity = lastActivity;
+  page->lockTrigger = lockTrigger;
+  page->killTrigger = killTrigger;
+  page->lockerPid = lockerPid;
+  page->updated = currentTime ();
+
+  statusBarrier ();
+  ++page->sequence;
+#endif /* HasMmap */
+}
+
+/*
+ *  Functions for multi-display mode (see session.c).
+ */
+void
+saveStatusPage (statusFile** s)
+{
+#ifdef HasMmap
+  *s = current;
+#else /* HasMmap */
+  *s = 0;
+#endif /* HasMmap */
+}
+
+void
+loadStatusPage (statusFile* s)
+{
+#ifdef HasMmap
+  current = s;
+#endif /* HasMmap */
+}
@@ -26,15 +26,25 @@
 #include "diy.h"
 #include "message.h"
 #include "engine.h"
+#include "idlealarm.h"
+#include "xinput.h"
+#include "control.h"
+#include "session.h"
+#include "monitors.h"
+#include "statuspage.h"
+#include "journal.h"
+#include "stats.h"
+#include "metrics.h"
 
 /*
  *  X error handler. We can safely ignore everything
  *  here (mainly windows that die before we get even
- *  see them).
+ *  see them), but do keep count.
  */
 static int
 catchFalseAlarm (Display* d, XErrorEvent event)
 {
+  ++xErrors;
   return 0;
 }
 
@@ -54,7 +64,7 @@ catchFalseAlarm (Display* d, XErrorEvent event)
 /*
  *  Window manager related stuff.
  */
-static void
+static Window
 wmSetup (Display* d)
 {
  /*
@@ -67,7 +77,8 @@ wmSetup (Display* d)
   *  requires it to be mapped.
   *
   *  If we're doing all this anyway, we might as well set the correct
-  *  WM properties on the window as a convenience.
+  *  WM properties on the window as a convenience. Also, the window
+  *  is where other xautolocks send their messages to.
   */
   Window               ourWin;    
   XTextProperty        nameProp;  
@@ -88,7 +99,638 @@ wmSetup (Display* d)
   (void) XFree (classInfo);
 
   (void) XMapWindow (d, ourWin);
+
+  return ourWin;
+}
+
+/*
+ *  Hangup support: a SIGHUP means the same as -reload. All that the
+ *  signal handler does is make a note of it, and wake up the main 
+ *  loop through a pipe, since that may well be sitting in poll().
+ */
+#ifdef HasPoll
+static int hangupPipe[2] = { -1, -1 }; /* see catchHangup () */
+#endif /* HasPoll */
+
+#ifndef VMS
+static volatile sig_atomic_t hungUp = 0; /* as it says */
+
+static void
+catchHangup (int sig)
+{
+  hungUp = 1;
+
+#ifdef HasPoll
+  {
+    int saved = errno; /* as it says */
+
+    if (hangupPipe[1] >= 0) (void) write (hangupPipe[1], "", 1);
+    errno = saved;
+  }
+#endif /* HasPoll */
+}
+#endif /* !VMS */
+
+static void
+initHangup (void)
+{
+#ifndef VMS
+  struct sigaction action; /* as it says   */
+#ifdef HasPoll
+  int              i;      /* loop counter */
+
+  if (pipe (hangupPipe))
+  {
+    hangupPipe[0] = hangupPipe[1] = -1;
+  }
+  else
+  {
+    for (i = 0; i < 2; ++i)
+    {
+      (void) fcntl (hangupPipe[i], F_SETFD, FD_CLOEXEC);
+      (void) fcntl (hangupPipe[i], F_SETFL, O_NONBLOCK);
+    }
+  }
+#endif /* HasPoll */
+
+  (void) memset (&action, 0, sizeof (action));
+  action.sa_handler = catchHangup;
+  (void) sigemptyset (&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  (void) sigaction (SIGHUP, &action, 0);
+#endif /* !VMS */
+}
+
+/*
+ *  Function for finding out whether we got a SIGHUP since the last
+ *  time we asked.
+ */
+static Bool
+hangupPending (void)
+{
+#ifndef VMS
+#ifdef HasPoll
+  char buffer[16]; /* as it says */
+
+  if (hangupPipe[0] >= 0)
+  {
+    while (read (hangupPipe[0], buffer, sizeof (buffer)) > 0)
+    {
+      /* drain the pipe */
+    }
+  }
+#endif /* HasPoll */
+
+  if (hungUp)
+  {
+    hungUp = 0;
+    return True;
+  }
+#endif /* !VMS */
+
+  return False;
+}
+
+/*
+ *  Function for finding out whether any of the corners or zones
+ *  is a `+' one, i.e. one we need to notice the pointer entering.
+ */
+static Bool
+plusCorners (void)
+{
+  int c; /* loop counter */
+
+  for (c = -1; ++c < 4; )
+  {
+    if (corners[c] == ca_forceLock) return True;
+  }
+
+  for (c = -1; ++c < (int) nofZones; )
+  {
+    if (zones[c].action == ca_forceLock) return True;
+  }
+
+  return False;
+}
+
+static unsigned seenReloads = 0; /* value of reloads we acted upon */
+
+/*
+ *  Event processing for when the server keeps track of the idle time.
+ */
+static void
+processOtherEvents (Display* d)
+{
+  XEvent event;
+
+  while (XPending (d))
+  {
+    (void) XNextEvent (d, &event);
+    handleEvent (d, &event);
+  }
+}
+
+/*
+ *  Tickless mode support. Returns whether anything woke us up before
+ *  the timeout expired.
+ */
+#ifdef HasPoll
+static Bool
+waitForActivity (Display* d, time_t timeout)
+{
+  struct pollfd fds[4 + MAX_CONTROL_FDS + MAX_METRICS_FDS];
+                                          /* as it says */
+  int           nofFds = 0;               /* as it says */
+  int           timerSlot = -1;           /* slot of the timer, or -1 */
+  int           ready;                    /* as it says */
+
+ /*
+  *  Events may already have been read from the connection (e.g. by
+  *  an XSync() somewhere along the line), in which case they will
+  *  not show up in poll(). Also flush out our own requests first,
+  *  since the server can't reply to what it never received.
+  *
+  *  A negative timeout means that only the server (or a control
+  *  socket client, or the locker exiting) can wake us up. Without
+  *  a display, we only wait for the latter two.
+  */
+  if (d)
+  {
+    if (XEventsQueued (d, QueuedAfterFlush)) return True;
+
+    fds[nofFds].fd = ConnectionNumber (d);
+    fds[nofFds++].events = POLLIN;
+  }
+
+  nofFds += addControlFds (fds + nofFds);
+  nofFds += addMetricsFds (fds + nofFds);
+
+  if (hangupPipe[0] >= 0)
+  {
+    fds[nofFds].fd = hangupPipe[0];
+    fds[nofFds++].events = POLLIN;
+  }
+
+  if (lockerFd >= 0)
+  {
+    fds[nofFds].fd = lockerFd;
+    fds[nofFds++].events = POLLIN;
+  }
+
+#ifdef HasBoottime
+ /*
+  *  The timeout of poll() doesn't include the time spent asleep, so 
+  *  after a suspend we'd only wake up for triggers that were due long
+  *  ago. A timer on the same clock as the triggers doesn't have that
+  *  problem.
+  */
+  {
+    static int        timer = -2; /* as it says */
+    struct itimerspec expiry;     /* as it says */
+
+    if (timer == -2) timer = timerfd_create (CLOCK_BOOTTIME, TFD_CLOEXEC);
+
+    if (timer >= 0 && timeout > 0)
+    {
+      (void) memset (&expiry, 0, sizeof (expiry));
+      expiry.it_value.tv_sec = timeout;
+
+      if (!timerfd_settime (timer, 0, &expiry, 0))
+      {
+        timerSlot = nofFds;
+        fds[nofFds].fd = timer;
+        fds[nofFds++].events = POLLIN;
+        timeout = -1;
+      }
+    }
+  }
+#endif /* HasBoottime */
+
+  ready = poll (fds, nofFds, timeout < 0 ? -1 : (int) timeout * 1000);
+
+ /*
+  *  The timer going off is just the timeout expiring.
+  */
+  if (ready == 1 && timerSlot >= 0 && fds[timerSlot].revents) return False;
+
+  return ready > 0;
+}
+#endif /* HasPoll */
+
+#ifdef HasPoll
+/*
+ *  Multi-display mode (see also session.c). Each session gets looked
+ *  after whenever it is due, or whenever its display or its locker
+ *  has something to say. Detecting user activity is left to the 
+ *  server, so the displays need to support either the MIT screen 
+ *  saver extension or Xidle.
+ *
+ *  Xlib normally exits when a connection breaks down, which would
+ *  take all of the other displays down with it. Hence we jump out 
+ *  of its error handler instead. By the time it calls that handler,
+ *  Xlib has marked the connection as broken and let go of it, so 
+ *  XCloseDisplay() no longer tries to talk to the server but merely
+ *  cleans up. Should it run into trouble all the same, we end up in
+ *  shutSession () once more, with nothing left to close.
+ */
+#define RETRY_DELAY     10    /* seconds between attempts to connect */
+#define RETIRED_DELAY   3600  /* a session we're no longer watching  */
+#define SCAN_INTERVAL   10    /* seconds between scans w/o inotify   */
+
+static jmp_buf  connectionLost;   /* where to go when a display dies */
+static pid_t*   abandoned = 0;    /* lockers of sessions that ended  */
+static unsigned nofAbandoned = 0; /* as it says                      */
+static Bool     reloadPending;    /* whether a SIGHUP awaits a display */
+
+static int
+catchConnectionLoss (Display* d)
+{
+  longjmp (connectionLost, 1);
+  return 0; /* keep gcc happy */
+}
+
+/*
+ *  Function for stopping to look after a session's display. A locker
+ *  that is still running is left alone (for all we know the display
+ *  is still there), but we do need to reap it once it is done.
+ */
+static void
+shutSession (session* s, Bool alive)
+{
+  if (lockerPid && waitpid (lockerPid, 0, WNOHANG) == 0)
+  {
+    if (nofAbandoned % 16 == 0)
+    {
+      pid_t* old = abandoned; /* as it says */
+
+      abandoned = newArray (pid_t, nofAbandoned + 16);
+      if (old)
+      {
+        (void) memcpy (abandoned, old, nofAbandoned * sizeof (pid_t));
+        free (old);
+      }
+    }
+
+    abandoned[nofAbandoned++] = lockerPid;
+  }
+
+  lockerPid = 0;
+  closeStatusPage ();
+
+  if (lockerFd >= 0)
+  {
+    (void) close (lockerFd);
+    lockerFd = -1;
+  }
+
+  if (s->display)
+  {
+    Display* d = s->display; /* as it says */
+
+    s->display = 0;
+    if (alive) releaseDisplay (d);
+    (void) XCloseDisplay (d);
+  }
+}
+
+static void
+reapAbandoned (void)
+{
+  unsigned i = 0; /* loop counter */
+
+  while (i < nofAbandoned)
+  {
+    if (waitpid (abandoned[i], 0, WNOHANG) != 0)
+    {
+      abandoned[i] = abandoned[--nofAbandoned];
+    }
+    else
+    {
+      ++i;
+    }
+  }
+}
+
+/*
+ *  Function for connecting to a session's display. Returns whether
+ *  that worked out.
+ */
+static Bool
+openSession (session* s)
+{
+  Display* d;         /* as it says */
+#if defined (HasXidle) || defined (HasScreenSaver)
+  int      dummy;     /* as it says */
+#endif /* HasXidle || HasScreenSaver */
+  Bool     usable;    /* as it says */
+
+  if (!(d = XOpenDisplay (s->name))) return False; /* = intended */
+
+  s->display = d;
+  (void) fcntl (ConnectionNumber (d), F_SETFD, FD_CLOEXEC);
+  initMonitors (d);
+
+#ifdef HasXidle
+  usable = s->useXidle = XidleQueryExtension (d, &dummy, &dummy);
+#else /* HasXidle */
+  usable = False;
+#endif /* HasXidle */
+
+#ifdef HasScreenSaver
+  if (!usable) usable = XScreenSaverQueryExtension (d, &dummy, &dummy);
+#endif /* HasScreenSaver */
+
+  if (!usable)
+  {
+    error1 ("%s can't tell how idle it is, ignoring it.\n", s->name);
+  }
+  else if (!claimDisplay (d, wmSetup (d)))
+  {
+    error2 ("Another %s is watching %s, ignoring it.\n", progName, s->name);
+    usable = False;
+  }
+
+  if (!usable)
+  {
+    s->retired = True;
+    shutSession (s, True);
+    return False;
+  }
+
+  s->pollPointer = plusCorners ();
+
+  noteActivity ();
+  resetTriggers ();
+  initStatusPage (d);
+  (void) XSync (d, 0);
+
+  return True;
+}
+
+/*
+ *  Function for looking after a session's display, much like the
+ *  main loop does in single display mode. Returns the number of 
+ *  seconds until it needs looking after again.
+ */
+static time_t
+serveSession (session* s)
+{
+  Display* d = s->display; /* as it says */
+  XEvent   event;          /* as it says */
+
+  if (reloadPending)
+  {
+    reloadPending = False;
+    (void) reloadSettings (d);
+  }
+
+  while (XPending (d))
+  {
+    (void) XNextEvent (d, &event);
+    handleEvent (d, &event);
+  }
+
+ /*
+  *  Whether it was a SIGHUP or a -reload, and no matter which display
+  *  it came through, it applies to all displays. The settings are
+  *  shared and the triggers of all sessions have already been taken
+  *  care of (see reloadSettings ()), but each session still needs to
+  *  catch up on what follows from them.
+  */
+  if (s->reloaded != reloads)
+  {
+    s->reloaded = reloads;
+    s->pollPointer = plusCorners ();
+  }
+
+  if (leave)
+  {
+    s->retired = True;
+    shutSession (s, True);
+    return RETIRED_DELAY;
+  }
+
+  queryIdleTime (d, s->useXidle);
+  queryPointer (d);
+  evaluateTriggers (d);
+  updateStatusPage ();
+  flushJournal (False);
+  (void) XFlush (d);
+
+  if (tickless && !s->pollPointer && !(lockerPid && lockerFd < 0))
+  {
+    return timeToNextTrigger ();
+  }
+
+  return 1;
+}
+
+static void
+attendSession (session* s, time_t now)
+{
+  time_t next = RETRY_DELAY; /* as it says */
+
+  enterSession (s);
+
+  if (setjmp (connectionLost))
+  {
+    shutSession (s, False);
+  }
+  else if (s->gone)
+  {
+    shutSession (s, True);
+  }
+  else if (s->retired)
+  {
+    next = RETIRED_DELAY;
+  }
+  else if (s->display || openSession (s))
+  {
+    next = serveSession (s);
+  }
+
+  leaveSession (s);
+
+  if (s->gone)
+  {
+    dropSession (s);
+  }
+  else
+  {
+    scheduleSession (s, now + next);
+  }
+}
+
+/*
+ *  The main loop of multi-display mode. Never returns.
+ */
+static void
+watchSessions (void)
+{
+  struct pollfd* fds = 0;       /* as it says                       */
+  session**      owners = 0;    /* session each of the fds is for   */
+  unsigned       maxFds = 0;    /* room in the above                */
+  unsigned       nofFds;        /* as it says                       */
+  unsigned       i;             /* loop counter                     */
+  int            notifyFd;      /* see watchDisplays ()             */
+  int            timeout;       /* milliseconds to wait for         */
+  time_t         now;           /* as it says                       */
+  time_t         nextScan = 0;  /* when to call scanDisplays ()     */
+  time_t         slept;         /* as it says                       */
+  session*       s;             /* as it says                       */
+
+  (void) XSetErrorHandler ((XErrorHandler) catchFalseAlarm);
+  (void) XSetIOErrorHandler (catchConnectionLoss);
+
+  initJournal ();
+  initHangup ();
+  initSessions (displayList);
+  notifyFd = watchDisplays ();
+
+  for (;;)
+  {
+    ++metrics.wakeups;
+    now = currentTime ();
+
+    if (notifyFd < 0 && now >= nextScan)
+    {
+      scanDisplays ();
+      nextScan = now + SCAN_INTERVAL;
+    }
+
+   /*
+    *  Reloading takes a display to read the resources from, so leave
+    *  it to the first session that has one. If none has, the reload
+    *  waits until one does.
+    */
+    if (hangupPending ()) reloadPending = True;
+
+    if (reloadPending)
+    {
+      for (i = 0; i < nofSessions && !sessions[i]->display; ++i)
+      {
+        /* find one */
+      }
+
+      if (i < nofSessions) scheduleSession (sessions[i], now);
+    }
+
+    if (detectSleep && (slept = timeAsleep ()) > 0) /* = intended */
+    {
+      for (i = 0; i < nofSessions; ++i)
+      {
+        enterSession (sessions[i]);
+        journal (jr_sleep, (long) slept);
+        resetLockTrigger ();
+        leaveSession (sessions[i]);
+      }
+    }
+
+    while (nofSessions && (s = sessions[0])->due <= now) /* = intended */
+    {
+      attendSession (s, now);
+    }
+
+    reapAbandoned ();
+
+   /*
+    *  Events that have already been read (say while waiting for the
+    *  reply to some request) won't show up in poll(), so the session
+    *  they are for needs looking after right away. One at a time, since
+    *  scheduling a session reorders the lot.
+    */
+    for (i = 0; i < nofSessions; ++i)
+    {
+      s = sessions[i];
+      if (s->display && XEventsQueued (s->display, QueuedAlready)) break;
+    }
+
+    if (i < nofSessions)
+    {
+      scheduleSession (s, now);
+      continue;
+    }
+
+   /*
+    *  Wait for the next session to become due, for any of the
+    *  displays or lockers to say something, or for a display to 
+    *  come or go.
+    */
+    if (maxFds < 2 * nofSessions + 2)
+    {
+      maxFds = 2 * nofSessions + 2;
+      if (fds) free (fds);
+      if (owners) free (owners);
+      fds = newArray (struct pollfd, maxFds);
+      owners = newArray (session*, maxFds);
+    }
+
+    nofFds = 0;
+    timeout = -1;
+
+    if (nofSessions)
+    {
+      timeout = sessions[0]->due - now < RETIRED_DELAY
+              ? (int) (sessions[0]->due - now) * 1000 
+              : RETIRED_DELAY * 1000;
+    }
+
+    if (notifyFd >= 0)
+    {
+      owners[nofFds] = 0;
+      fds[nofFds].fd = notifyFd;
+      fds[nofFds++].events = POLLIN;
+    }
+    else if (timeout < 0 || timeout > SCAN_INTERVAL * 1000)
+    {
+      timeout = SCAN_INTERVAL * 1000;
+    }
+
+    if (hangupPipe[0] >= 0)
+    {
+      owners[nofFds] = 0;
+      fds[nofFds].fd = hangupPipe[0];
+      fds[nofFds++].events = POLLIN;
+    }
+
+    for (i = 0; i < nofSessions; ++i)
+    {
+      s = sessions[i];
+
+      if (!s->display) continue;
+
+      owners[nofFds] = s;
+      fds[nofFds].fd = ConnectionNumber (s->display);
+      fds[nofFds++].events = POLLIN;
+
+      if (s->state.lockerFd >= 0)
+      {
+        owners[nofFds] = s;
+        fds[nofFds].fd = s->state.lockerFd;
+        fds[nofFds++].events = POLLIN;
+      }
+    }
+
+    if (poll (fds, nofFds, timeout) <= 0) continue;
+
+    now = currentTime ();
+
+    for (i = 0; i < nofFds; ++i)
+    {
+      if (!fds[i].revents) continue;
+
+      if (owners[i])
+      {
+        scheduleSession (owners[i], now);
+      }
+      else if (fds[i].fd == notifyFd)
+      {
+        scanDisplays ();
+      }
+    }
+  }
 }
+#endif /* HasPoll */
 
 /*
  *  Combat control.
@@ -98,8 +740,18 @@ main (int argc, char* argv[])
 {
   Display* d;
   time_t   t0, t1;
+  time_t   sleepTime = 1;
+  time_t   slept;
+  Bool     exactSleep;
   Bool     useMit = False;
   Bool     useXidle = False;
+  Bool     useSync = False;
+  Bool     useXInput = False;
+  Bool     gotInput = False;
+  Bool     gotMotion = False;
+  Bool     watchPointer = False;
+  Bool     pollPointer;
+  Bool     pointerEvents = False;
 
  /*
   *  Find out whether there actually is a server on the other side...
@@ -114,28 +766,97 @@ main (int argc, char* argv[])
   *  More initialisations.
   */
   initState (argc, argv);
+  initMonitors (d);
   processOpts (d, argc, argv);
-  wmSetup (d);
-  checkConnectionAndSendMessage (d);
+
+#ifdef HasPoll
+  if (displayList && !messageToSend)
+  {
+    XCloseDisplay (d);
+
+    if (!noCloseOut) (void) fclose (stdout);
+    if (!noCloseErr) (void) fclose (stderr);
+
+    watchSessions ();
+  }
+#endif /* HasPoll */
+  checkConnectionAndSendMessage (d, wmSetup (d));
+  initControl (d);
+  initMetrics (d);
+  initJournal ();
+  initHangup ();
+  journalDisplay (DisplayString (d));
+  loadStats (newStats (DisplayString (d)));
+  noteActivity ();
   resetTriggers ();
+  initStatusPage (d);
 
   if (!noCloseOut) (void) fclose (stdout);
   if (!noCloseErr) (void) fclose (stderr);
 
+#ifdef HasSync
+ /*
+  *  Letting the server tell us about user (in)activity only makes
+  *  sense if we don't wake up every second anyway.
+  */
+  if (tickless && !forceDiy) useSync = initIdleAlarms (d);
+#endif /* HasSync */
+
 #ifdef HasXidle
-  queryExtension (Xidle, useXidle)
+  if (!forceDiy && !useSync) queryExtension (Xidle, useXidle)
 #endif /* HasXidle */
 
 #ifdef HasScreenSaver
-  if (!useXidle) queryExtension (XScreenSaver, useMit)
+  if (!forceDiy && !useSync && !useXidle)
+  {
+    queryExtension (XScreenSaver, useMit)
+  }
 #endif /* HasScreenSaver */
 
-  if (!useXidle && !useMit) initDiy (d);
+  if (!forceDiy && !useSync && !useXidle && !useMit)
+  {
+    useXInput = initXInput (d);
+  }
+
+  if (!useSync && !useXidle && !useMit && !useXInput) initDiy (d);
+
+ /*
+  *  Find out whether we can afford to sleep for more than a second
+  *  in tickless mode. In DIY mode, the only way to find out about
+  *  pointer movements is to periodically ask for them, and the same
+  *  goes for noticing that the pointer entered a `+' corner. All of
+  *  the other triggers are predictable.
+  */
+  pollPointer = !useSync && !useXidle && !useMit && !useXInput;
+
+ /*
+  *  Unless the server tells us when the pointer moves, that is. Then
+  *  we don't need to ask for it when nothing happens. In tickless
+  *  mode, hearing about each move only pays off if it spares us the
+  *  polling for `+' corners.
+  */
+  if (useXInput)
+  {
+    usePointerEvents ();
+    pointerEvents = True;
+  }
+  else if (   !pollPointer
+           && (!tickless || plusCorners ())
+           && initPointerEvents (d))
+  {
+    usePointerEvents ();
+    pointerEvents = True;
+  }
+  else if (plusCorners ())
+  {
+    pollPointer = True;
+  }
 
   (void) XSetErrorHandler ((XErrorHandler) catchFalseAlarm);
   (void) XSync (d, 0);
 
-  t0 = time (NULL);
+  t0 = currentTime ();
+  exactSleep = timeAsleep () >= 0;
 
 
  /*
@@ -143,26 +864,145 @@ main (int argc, char* argv[])
   */
   for (;;)
   {
-    lookForMessages (d);
+    ++metrics.wakeups;
+    processControl (d);
+    processMetrics (d);
+    gotInput = False;
 
-    if (useXidle || useMit)
+    if (hangupPending ()) (void) reloadSettings (d);
+
+   /*
+    *  New settings may come with new `+' corners, which need to be
+    *  looked out for.
+    */
+    if (reloads != seenReloads)
     {
+      seenReloads = reloads;
+      if (!pointerEvents && plusCorners ()) pollPointer = True;
+    }
+
+   /*
+    *  When the server tells us about moves, the dwell time in a `+'
+    *  corner starts as soon as we read the move, so we'd better not
+    *  leave it lying around.
+    */
+    watchPointer = pointerEvents && plusCorners ();
+
+    if (useSync)
+    {
+     /*
+      *  The status page is only as good as what we know. While the
+      *  user is busy, the alarms don't tell us, so ask.
+      */
+      if (writeStatus) refreshIdleTime (d);
+      processAlarms (d);
+    }
+    else if (useXidle || useMit)
+    {
+      processOtherEvents (d);
       queryIdleTime (d, useXidle);
     }
+    else if (useXInput)
+    {
+      gotInput = processRawEvents (d);
+    }
     else
     {
       processEvents ();
     }
 
-    queryPointer (d);
+    if ((gotMotion = queryPointer (d))) gotInput = True; /* = intended */
     evaluateTriggers (d);
+    updateStatusPage ();
+    flushJournal (False);
 
-    (void) sleep (1);
+#ifdef HasPoll
+    if (tickless)
+    {
+     /*
+      *  As long as there is a locker around, we still need to look 
+      *  after it every second, unless the kernel can tell us when it
+      *  exits (see lockerStarted ()). When using the SYNC extension,
+      *  the server will wake us up when a trigger is due. Unless the 
+      *  kernel can tell us how long we've been asleep, we also need
+      *  a timeout of our own to guess that.
+      */
+      if (pollPointer || (lockerPid && lockerFd < 0))
+      {
+        sleepTime = 1;
+      }
+      else if (useSync && (!detectSleep || exactSleep))
+      {
+        sleepTime = -1;
+      }
+      else
+      {
+        sleepTime = timeToNextTrigger ();
+      }
 
+     /*
+      *  While the user is busy, raw input events keep pouring in. 
+      *  There is no point in waking up for each and every one of 
+      *  them, so let them pile up for a while. Everything else (the
+      *  control socket, SIGHUP, the locker exiting, ...) still gets
+      *  our attention right away, and so does the pointer if it may
+      *  be heading for a `+' corner.
+      */
+      if (gotInput && sleepTime > 1 && !(watchPointer && gotMotion))
+      {
+        (void) XFlush (d);
+
+        if (!waitForActivity ((Display*) 0, 1))
+        {
+          (void) waitForActivity (d, sleepTime - 1);
+        }
+      }
+      else
+      {
+        (void) waitForActivity (d, sleepTime);
+      }
+    }
+    else
+    {
+     /*
+      *  Don't let the tick get in the way of timing the locker, or
+      *  the dwell time in a `+' corner.
+      */
+      (void) XFlush (d);
+      (void) waitForActivity (   awaitingLocker () || watchPointer
+                              ? d : (Display*) 0, 1);
+    }
+#else /* HasPoll */
+    {
+      (void) gotInput;     /* only matters in tickless mode  */
+      (void) exactSleep;   /* ditto                          */
+      (void) gotMotion;    /* ditto                          */
+      (void) watchPointer; /* only matters when using poll() */
+      (void) sleep (1);
+    }
+#endif /* HasPoll */
+
+   /*
+    *  Preferably, the kernel tells us whether the machine has been 
+    *  suspended. If not, we guess it from a big time jump. In tickless
+    *  mode, we may have been asleep for quite a while on purpose, so 
+    *  only count the time beyond what we asked for.
+    */
     if (detectSleep)
     {
-      t1 = time (NULL);
-      if ((unsigned long) t1 - (unsigned long) t0 > 3) resetLockTrigger ();
+      t1 = currentTime ();
+
+      if ((slept = timeAsleep ()) < 0) /* = intended */
+      {
+        slept = t1 - t0 - (sleepTime + 2);
+      }
+
+      if (slept > 0)
+      {
+        journal (jr_sleep, (long) slept);
+        resetLockTrigger ();
+      }
+
       t0 = t1;
     }
   }
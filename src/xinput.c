@@ -0,0 +1,190 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It implements
+ *          the stuff used when the program is not using a screen saver
+ *          extension, but the X server supports version 2 of the X
+ *          Input extension.
+ *
+ *          The basic idea is that raw input events are delivered to the
+ *          root window no matter which window has the focus, whether
+ *          some other client has grabbed the device, or how the event 
+ *          propagation mechanism would otherwise treat them. So all we
+ *          have to do is ask for them once per screen, instead of 
+ *          having to keep track of the whole window tree like the DIY
+ *          approach does. As an extra, this also catches button presses
+ *          and pointer movements. The latter are also useful along
+ *          with the other ways of detecting activity, as they tell us
+ *          when to look for the pointer being in one of the corners.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ * 
+ * --------------------------------------------------------------------------
+ * 
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ * 
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#include "xinput.h"
+#include "engine.h"
+#include "state.h"
+#include "options.h"
+#include "miscutil.h"
+
+#ifdef HasXInput2
+static int xiOpcode; /* major opcode of the X Input extension */
+#endif /* HasXInput2 */
+
+/*
+ *  Function for recognising the raw events we asked for. Motion gets
+ *  passed on to the engine, which then knows it's time to look where
+ *  the pointer went. Returns whether it was one of ours.
+ */
+Bool
+processPointerEvent (XEvent* event)
+{
+#ifdef HasXInput2
+ /*
+  *  We only ask for raw input events, and don't care about the 
+  *  details. So there is no need to call XGetEventData().
+  */
+  if (   event->xcookie.type == GenericEvent
+      && event->xcookie.extension == xiOpcode)
+  {
+    if (event->xcookie.evtype == XI_RawMotion) notePointerMotion ();
+    return True;
+  }
+#endif /* HasXInput2 */
+
+  return False;
+}
+
+/*
+ *  Function for processing any events that have come in since
+ *  last time. It is crucial that this function does not block
+ *  in case nothing interesting happened. Returns whether there
+ *  was any user input.
+ */
+Bool
+processRawEvents (Display* d)
+{
+  Bool gotInput = False; /* as it says */
+
+#ifdef HasXInput2
+  while (XPending (d))
+  {
+    XEvent event;
+
+    (void) XNextEvent (d, &event);
+
+    if (processPointerEvent (&event))
+    {
+      gotInput = True;
+    }
+    else
+    {
+      handleEvent (d, &event);
+    }
+  }
+
+  if (gotInput)
+  {
+    noteActivity ();
+    resetTriggers ();
+  }
+#endif /* HasXInput2 */
+
+  return gotInput;
+}
+
+#ifdef HasXInput2
+/*
+ *  Function for asking for raw events of the given types on all
+ *  screens. Returns whether the server is able to provide them.
+ */
+static Bool
+selectRawEvents (Display* d, Bool allInput)
+{
+  int           dummy;                          /* as it says    */
+  int           major = 2;                      /* as it says    */
+  int           minor = 1;                      /* as it says    */
+  int           s;                              /* screen number */
+  unsigned char bits[XIMaskLen (XI_LASTEVENT)]; /* event mask    */
+  XIEventMask   mask;                           /* as it says    */
+
+  if (!XQueryExtension (d, "XInputExtension", &xiOpcode, &dummy, &dummy))
+  {
+    return False;
+  }
+
+ /*
+  *  Version 2.0 does not deliver raw events to us while some other 
+  *  client has grabbed the device. Since that is exactly what the
+  *  typical locker does, we really need 2.1 or better.
+  */
+  if (   XIQueryVersion (d, &major, &minor) != Success
+      || major < 2
+      || (major == 2 && minor < 1))
+  {
+    return False;
+  }
+
+  (void) memset (bits, 0, sizeof (bits));
+  XISetMask (bits, XI_RawMotion);
+
+  if (allInput)
+  {
+    XISetMask (bits, XI_RawKeyPress);
+    XISetMask (bits, XI_RawButtonPress);
+  }
+
+  mask.deviceid = XIAllMasterDevices;
+  mask.mask_len = sizeof (bits);
+  mask.mask = bits;
+
+  for (s = -1; ++s < ScreenCount (d); )
+  {
+    (void) XISelectEvents (d, RootWindowOfScreen (ScreenOfDisplay (d, s)),
+                           &mask, 1);
+  }
+
+  return True;
+}
+#endif /* HasXInput2 */
+
+/*
+ *  Function for initialising the whole shebang. Returns whether
+ *  the server is able to provide what we need.
+ */
+Bool
+initXInput (Display* d)
+{
+#ifdef HasXInput2
+  return selectRawEvents (d, True);
+#else /* HasXInput2 */
+  return False;
+#endif /* HasXInput2 */
+}
+
+/*
+ *  Function for only hearing about pointer motion, for use along 
+ *  with one of the other ways of detecting activity. Raw events
+ *  reach the root window no matter what clients do with the 
+ *  regular ones, and unlike pointer barriers they don't get in 
+ *  the user's way. Returns whether the server can provide them.
+ */
+Bool
+initPointerEvents (Display* d)
+{
+#ifdef HasXInput2
+  return selectRawEvents (d, False);
+#else /* HasXInput2 */
+  return False;
+#endif /* HasXInput2 */
+}
@@ -0,0 +1,152 @@
+/*****************************************************************************
+ *
+ * Authors: Michel Eyckmans (MCE) & Stefan De Troch (SDT)
+ *
+ * Content: This file is part of version 2.x of xautolock. It implements
+ *          a reader for the journal kept by xautolock -journal. It is
+ *          not part of xautolock itself.
+ *
+ *          Usage: xajournal [-json] [file ...]
+ *
+ *          Reads the given journals (or stdin) and prints their records
+ *          as CSV, or as a JSON array with -json. Times are in seconds
+ *          since the epoch, with microseconds after the dot.
+ *
+ *          Please send bug reports etc. to mce@scarlet.be.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Copyright 1990, 1992-1999, 2001-2002, 2004, 2007 by  Stefan De Troch and
+ * Michel Eyckmans.
+ *
+ * Versions 2.0 and above of xautolock are available under version 2 of the
+ * GNU GPL. Earlier versions are available under other conditions. For more
+ * information, see the License file.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "journal.h"
+
+static const char* typeNames[] =
+{
+  0, "activity", "notify", "lock", "unlock", "kill",
+  "disable", "enable", "sleep", "lost"
+};
+
+static int json = 0;      /* whether to print JSON rather than CSV */
+static int printed = 0;   /* records printed so far                */
+
+/*
+ *  Function for printing a single record.
+ */
+static void
+printRecord (const journalRecord* r)
+{
+  char        unknown[16];  /* name of types we don't know yet */
+  const char* name;         /* as it says                      */
+  long long   us = r->time; /* as it says                      */
+
+  if (r->type < sizeof (typeNames) / sizeof (typeNames[0]) && r->type)
+  {
+    name = typeNames[r->type];
+  }
+  else
+  {
+    (void) sprintf (unknown, "%u", (unsigned) r->type);
+    name = unknown;
+  }
+
+  if (json)
+  {
+    (void) printf ("%s\n  {\"time\": %lld.%06lld, \"event\": \"%s\", "
+                   "\"display\": %d, \"value\": %ld}",
+                   printed ? "," : "", us / 1000000, us % 1000000, name,
+                   (int) r->display, (long) r->value);
+  }
+  else
+  {
+    (void) printf ("%lld.%06lld,%s,%d,%ld\n", us / 1000000, us % 1000000,
+                   name, (int) r->display, (long) r->value);
+  }
+
+  ++printed;
+}
+
+/*
+ *  Function for printing a whole journal. Returns whether it was one.
+ */
+static int
+readJournal (FILE* f, const char* name)
+{
+  journalHeader header;  /* as it says */
+  journalRecord record;  /* as it says */
+
+  if (   fread (&header, sizeof (header), 1, f) != 1
+      || memcmp (header.magic, JOURNAL_MAGIC, sizeof (header.magic))
+      || header.recordSize != sizeof (record))
+  {
+    (void) fprintf (stderr, "xajournal: %s is not a journal.\n", name);
+    return 0;
+  }
+
+  while (fread (&record, sizeof (record), 1, f) == 1)
+  {
+    printRecord (&record);
+  }
+
+  return 1;
+}
+
+int
+main (int argc, char* argv[])
+{
+  FILE* f;       /* as it says    */
+  int   ok = 1;  /* as it says    */
+  int   i = 1;   /* loop counter  */
+
+  if (i < argc && !strcmp (argv[i], "-json"))
+  {
+    json = 1;
+    ++i;
+  }
+
+  if (i < argc && argv[i][0] == '-' && argv[i][1])
+  {
+    (void) fprintf (stderr, "Usage : xajournal [-json] [file ...]\n");
+    return EXIT_FAILURE;
+  }
+
+  if (json) (void) printf ("[");
+  else      (void) printf ("time,event,display,value\n");
+
+  if (i == argc)
+  {
+    ok = readJournal (stdin, "stdin");
+  }
+
+  for (; i < argc; ++i)
+  {
+    if (!strcmp (argv[i], "-"))
+    {
+      ok &= readJournal (stdin, "stdin");
+    }
+    else if (!(f = fopen (argv[i], "rb"))) /* = intended */
+    {
+      (void) fprintf (stderr, "xajournal: can't open %s.\n", argv[i]);
+      ok = 0;
+    }
+    else
+    {
+      ok &= readJournal (f, argv[i]);
+      (void) fclose (f);
+    }
+  }
+
+  if (json) (void) printf ("%s]\n", printed ? "\n" : "");
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}